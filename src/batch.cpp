@@ -0,0 +1,201 @@
+#include <opencv2/core/core.hpp>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace cv;
+
+#include "batch.h"
+
+typedef struct QRBatch{
+	QRThreadPool   *pool;
+	int             nthreads;
+	QRLocator     **locators;  //每个线程一个，不使用线程池
+	QRLocator     **large;     //每个线程一个，处理大图，带作为嵌套任务分给线程池
+
+	//当前这一批
+	Mat            *images;
+	QRBatchResult  *results;
+	int            *order;     //图像下标，大图在前
+	int             nlarge;
+	int             capacity;
+} QRBatch;
+
+//ProcessImage能处理的图像
+static int _isValidImage(const Mat &image)
+{
+	if (image.empty() || CV_8U != image.depth()){
+		return 0;
+	}
+
+	return 1 == image.channels() || 3 == image.channels() || 4 == image.channels();
+}
+
+//大图的二值化和扫描分带在所有线程上执行
+static int _isLarge(const QRBatch *batch, const Mat &image)
+{
+	return batch->nthreads > 1 && _isValidImage(image) &&
+	       (double)image.cols * image.rows > QR_CONFIG_BATCH_SPLIT_AREA;
+}
+
+static void _locateOne(QRLocator *locator, Mat &image, QRBatchResult *result)
+{
+	Mat binary;
+	Mat qrimg;
+
+	result->ncenters = 0;
+	result->centers = NULL;
+	result->ncodes = 0;
+	result->codes = NULL;
+	result->ngrids = 0;
+	result->grids = NULL;
+	result->qrimg.release();
+	if (!_isValidImage(image)){
+		result->status = QR_BATCH_BAD_IMAGE;
+		return;
+	}
+
+	if (0 != locator->ProcessImage(image, binary, qrimg)){
+		result->status = QR_BATCH_NOT_FOUND;
+	} else {
+		result->status = QR_BATCH_FOUND;
+		//qrimg指向locator的工作区，下一幅图像会覆盖
+		qrimg.copyTo(result->qrimg);
+	}
+
+	locator->SaveCodes(result->codeBuf, &result->centers, &result->ncenters, &result->codes, &result->ncodes);
+	locator->SaveGrids(result->gridBuf, &result->grids, &result->ngrids);
+
+	return;
+}
+
+static void _runImage(void *arg, int index, int worker)
+{
+	QRBatch *batch;
+	int i;
+
+	batch = (QRBatch *)arg;
+	i = batch->order[index];
+	if (index < batch->nlarge){
+		_locateOne(batch->large[worker], batch->images[i], batch->results + i);
+	} else {
+		_locateOne(batch->locators[worker], batch->images[i], batch->results + i);
+	}
+}
+
+QR_BATCH QR_CreateBatch(int nthreads, const QRLocatorConfig *config)
+{
+	QRLocatorConfig cfg;
+	QRBatch *batch;
+	int i;
+
+	if (NULL == config){
+		QR_GetDefaultConfig(&cfg);
+	} else {
+		cfg = *config;
+	}
+	//线程由batch统一管理
+	cfg.threads = 0;
+
+	batch = (QRBatch *)calloc(1, sizeof(QRBatch));
+	if (NULL == batch){
+		return NULL;
+	}
+
+	batch->pool = QR_CreateThreadPool(MAX(1, nthreads));
+	batch->nthreads = QR_ThreadPoolSize(batch->pool);
+	batch->locators = (QRLocator **)calloc(batch->nthreads, sizeof(QRLocator *));
+	batch->large = (QRLocator **)calloc(batch->nthreads, sizeof(QRLocator *));
+	if (NULL == batch->pool || NULL == batch->locators || NULL == batch->large){
+		QR_DestroyBatch((QR_BATCH)batch);
+		return NULL;
+	}
+
+	for (i = 0; i < batch->nthreads; ++i){
+		batch->locators[i] = new QRLocator();
+		batch->locators[i]->SetConfig(cfg);
+		batch->large[i] = new QRLocator();
+		batch->large[i]->SetConfig(cfg);
+		batch->large[i]->SetThreadPool(batch->pool);
+	}
+
+	return (QR_BATCH)batch;
+}
+
+void QR_DestroyBatch(QR_BATCH handle)
+{
+	QRBatch *batch;
+	int i;
+
+	batch = (QRBatch *)handle;
+	if (NULL == batch){
+		return;
+	}
+
+	//locator先释放，它们可能还引用着线程池
+	for (i = 0; i < batch->nthreads; ++i){
+		if (NULL != batch->large){
+			delete batch->large[i];
+		}
+		if (NULL != batch->locators){
+			delete batch->locators[i];
+		}
+	}
+	free(batch->large);
+	free(batch->locators);
+	free(batch->order);
+	QR_DestroyThreadPool(batch->pool);
+	free(batch);
+
+	return;
+}
+
+int QR_ProcessBatch(QR_BATCH handle, Mat *images, int count, QRBatchResult *results)
+{
+	QRBatch *batch;
+	int nfound;
+	int n;
+	int i;
+
+	batch = (QRBatch *)handle;
+	if (NULL == batch || count < 0 || (count > 0 && (NULL == images || NULL == results))){
+		return -1;
+	}
+
+	if (count > batch->capacity){
+		free(batch->order);
+		batch->order = (int *)malloc(sizeof(int) * count);
+		batch->capacity = (NULL == batch->order) ? 0 : count;
+		if (NULL == batch->order){
+			return -1;
+		}
+	}
+	batch->images = images;
+	batch->results = results;
+
+	//大图排在前面最先开始，小图保持原来的顺序
+	batch->nlarge = 0;
+	for (i = 0; i < count; ++i){
+		if (_isLarge(batch, images[i])){
+			batch->order[batch->nlarge++] = i;
+		}
+	}
+	n = batch->nlarge;
+	for (i = 0; i < count; ++i){
+		if (!_isLarge(batch, images[i])){
+			batch->order[n++] = i;
+		}
+	}
+
+	//所有图像是一组任务，大图的带是嵌套的任务，空闲的线程先领取它们再领下一幅图像
+	QR_RunTasks(batch->pool, _runImage, batch, count);
+
+	nfound = 0;
+	for (i = 0; i < count; ++i){
+		if (QR_BATCH_FOUND == results[i].status){
+			nfound += 1;
+		}
+	}
+
+	return nfound;
+}
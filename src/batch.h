@@ -0,0 +1,47 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "locator.h"
+
+//整幅图像超过这个面积时拆成带，由所有线程一起二值化和扫描
+#define QR_CONFIG_BATCH_SPLIT_AREA (4 * 1000 * 1000)
+
+//每幅图像的处理结果
+enum{
+	QR_BATCH_FOUND = 0,      //找到并裁剪出了二维码
+	QR_BATCH_NOT_FOUND = -1, //没有找到二维码
+	QR_BATCH_BAD_IMAGE = -2, //图像为空或者格式不支持
+};
+
+typedef struct QRBatchResult{
+	int            status;   //QR_BATCH_xxx
+	int            ncenters;
+	QRFinderCenter *centers; //指向codeBuf
+	int            ncodes;
+	QRCodeRegion   *codes;   //每个二维码在图像中的范围，指向codeBuf
+	int            ngrids;
+	QRCodeGrid     *grids;   //config.grid为1时每个二维码的位矩阵，指向gridBuf
+	Mat            qrimg;    //裁剪出的第一个二维码，属于结果自己
+	Mat            codeBuf;  //centers和codes的存储，属于结果自己，只增不减
+	Mat            gridBuf;  //grids和它们的位，属于结果自己，只增不减
+} QRBatchResult;
+
+/*Locate codes in many images at once.
+  A batch owns a thread pool and one locator per thread, both kept across
+   calls.
+  Every image is one task handed out to whichever thread is free, images
+   larger than QR_CONFIG_BATCH_SPLIT_AREA first. A large image binarizes and
+   scans its row and column bands as nested tasks of the same pool, which
+   the other threads take up between their small images, so a single large
+   scan neither holds up the rest of the batch nor leaves threads idle.
+  Results are stored at the index of their image.*/
+typedef struct QRBatchHandle_ *QR_BATCH;
+
+//nthreads包括调用者自己，config为NULL时使用默认参数
+extern QR_BATCH QR_CreateBatch(int nthreads, const QRLocatorConfig *config);
+extern void QR_DestroyBatch(QR_BATCH batch);
+
+//返回找到二维码的图像数，参数错误时返回-1
+extern int QR_ProcessBatch(QR_BATCH batch, Mat *images, int count, QRBatchResult *results);
+
+#endif
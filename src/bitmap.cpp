@@ -0,0 +1,201 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bitmap.h"
+
+#define QR_ALL_ONES (~(uint64_t)0)
+
+//最后一个字中属于图像的位
+static uint64_t _tailMask(int width)
+{
+	return (0 == (width & 63)) ? QR_ALL_ONES : (((uint64_t)1 << (width & 63)) - 1);
+}
+
+/*Horizontal neighbours of a word.
+  prev and next are the words to the left and right; at the ends of the row
+   they are replaced by fill, the value that leaves the operation unchanged.*/
+static uint64_t _leftOf(uint64_t w, uint64_t prev)
+{
+	return (w << 1) | (prev >> 63);
+}
+
+static uint64_t _rightOf(uint64_t w, uint64_t next)
+{
+	return (w >> 1) | (next << 63);
+}
+
+/*One row of the 3x3 cross dilation (max) or erosion (min).
+  Missing rows above and below are given as mid, which is neutral for both.*/
+static void _dilateRow(const uint64_t *up, const uint64_t *mid, const uint64_t *down, int words, uint64_t *out)
+{
+	uint64_t prev;
+	uint64_t next;
+	int k;
+
+	prev = 0;
+	for (k = 0; k < words; ++k){
+		next = (k + 1 < words) ? mid[k + 1] : 0;
+		out[k] = mid[k] | _leftOf(mid[k], prev) | _rightOf(mid[k], next) | up[k] | down[k];
+		prev = mid[k];
+	}
+}
+
+static void _erodeRow(const uint64_t *up, const uint64_t *mid, const uint64_t *down, int words, uint64_t *out)
+{
+	uint64_t prev;
+	uint64_t next;
+	int k;
+
+	prev = QR_ALL_ONES;
+	for (k = 0; k < words; ++k){
+		next = (k + 1 < words) ? mid[k + 1] : QR_ALL_ONES;
+		out[k] = mid[k] & _leftOf(mid[k], prev) & _rightOf(mid[k], next) & up[k] & down[k];
+		prev = mid[k];
+	}
+}
+
+void QR_DilateBitRows(const uint64_t *src, uint64_t *tmp, int width, int height, int words, int y0, int y1)
+{
+	const uint64_t *mid;
+	uint64_t tail;
+	int y;
+
+	tail = _tailMask(width);
+	for (y = y0; y < y1; ++y){
+		mid = src + y * words;
+		_dilateRow((y > 0) ? mid - words : mid, mid, (y + 1 < height) ? mid + words : mid, words, tmp + y * words);
+
+		//图像外的位在腐蚀时不起作用
+		tmp[y * words + words - 1] |= ~tail;
+	}
+
+	return;
+}
+
+void QR_ErodeBitRows(const uint64_t *tmp, uint64_t *dst, int width, int height, int words, int y0, int y1)
+{
+	const uint64_t *mid;
+	uint64_t tail;
+	int y;
+
+	tail = _tailMask(width);
+	for (y = y0; y < y1; ++y){
+		mid = tmp + y * words;
+		_erodeRow((y > 0) ? mid - words : mid, mid, (y + 1 < height) ? mid + words : mid, words, dst + y * words);
+		dst[y * words + words - 1] &= tail;
+	}
+
+	return;
+}
+
+void QR_CloseBits(const uint64_t *src, uint64_t *dst, uint64_t *tmp, int width, int height, int words)
+{
+	if (width <= 0 || height <= 0){
+		return;
+	}
+
+	QR_DilateBitRows(src, tmp, width, height, words, 0, height);
+	QR_ErodeBitRows(tmp, dst, width, height, words, 0, height);
+
+	return;
+}
+
+//取出差异字中所有为1的位
+static int _extractBits(uint64_t diff, int base, int *out, int nout)
+{
+	while (0 != diff){
+		out[nout++] = base + __builtin_ctzll(diff);
+		diff &= diff - 1;
+	}
+
+	return nout;
+}
+
+int QR_FindBitTransitions(const uint64_t *row, int width, int *edges)
+{
+	uint64_t prev;
+	uint64_t diff;
+	int words;
+	int nedges;
+	int k;
+
+	words = QR_BITMAP_WORDS(width);
+	nedges = 0;
+	prev = 0;
+	for (k = 0; k < words; ++k){
+		//每一位和它左边的像素比较
+		diff = row[k] ^ _leftOf(row[k], prev);
+		if (0 == k){
+			diff &= ~(uint64_t)1;
+		}
+		if (k + 1 == words){
+			diff &= _tailMask(width);
+		}
+		nedges = _extractBits(diff, k << 6, edges, nedges);
+		prev = row[k];
+	}
+
+	return nedges;
+}
+
+int QR_FindBitColumnTransitions(const uint64_t *bits, int words, int x, int y0, int n, int *edges)
+{
+	const uint64_t *p;
+	int shift;
+	int last;
+	int cur;
+	int nedges;
+	int y;
+
+	if (n < 2){
+		return 0;
+	}
+
+	p = bits + (size_t)y0 * words + (x >> 6);
+	shift = x & 63;
+	last = (int)(*p >> shift) & 1;
+	nedges = 0;
+	for (y = 1; y < n; ++y){
+		p += words;
+		cur = (int)(*p >> shift) & 1;
+		if (cur != last){
+			edges[nedges++] = y;
+			last = cur;
+		}
+	}
+
+	return nedges;
+}
+
+int QR_FindBitChanges(const uint64_t *a, const uint64_t *b, int words, int *out)
+{
+	int nout;
+	int k;
+
+	nout = 0;
+	for (k = 0; k < words; ++k){
+		if (a[k] != b[k]){
+			nout = _extractBits(a[k] ^ b[k], k << 6, out, nout);
+		}
+	}
+
+	return nout;
+}
+
+void QR_UnpackBits(const uint64_t *bits, int words, int width, int height, unsigned char *dst, int step)
+{
+	const uint64_t *row;
+	unsigned char *line;
+	int x;
+	int y;
+
+	for (y = 0; y < height; ++y){
+		row = bits + (size_t)y * words;
+		line = dst + (size_t)y * step;
+		for (x = 0; x < width; ++x){
+			line[x] = ((row[x >> 6] >> (x & 63)) & 1) ? 0xFF : 0x00;
+		}
+	}
+
+	return;
+}
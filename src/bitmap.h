@@ -0,0 +1,43 @@
+#ifndef _BITMAP_H_
+#define _BITMAP_H_
+
+#include <stdint.h>
+
+/*1 bit per pixel binary images.
+  Pixel x of a row is bit (x & 63) of word x >> 6, a set bit is white.
+  Every row starts on a word boundary and the bits after the last pixel of a
+   row are always 0.*/
+
+//一行需要的64位字数
+#define QR_BITMAP_WORDS(width) (((width) + 63) >> 6)
+
+/*Morphological close (dilate, then erode) with the 3x3 cross, the same as
+   morphologyEx(MORPH_CLOSE) with the 3x3 ellipse and the default border.
+  src and dst may be the same; tmp holds the dilated image and must not
+   overlap either of them.*/
+extern void QR_CloseBits(const uint64_t *src, uint64_t *dst, uint64_t *tmp, int width, int height, int words);
+
+/*The two halves of QR_CloseBits on rows y0 .. y1-1 only, so row bands can
+   run on different threads. Every band must finish QR_DilateBitRows before
+   any band starts QR_ErodeBitRows.*/
+extern void QR_DilateBitRows(const uint64_t *src, uint64_t *tmp, int width, int height, int words, int y0, int y1);
+extern void QR_ErodeBitRows(const uint64_t *tmp, uint64_t *dst, int width, int height, int words, int y0, int y1);
+
+/*Find the colour transitions along one bitmap row, with the same output as
+   QR_FindTransitions on the unpacked row.
+  Return: The number of transitions found.*/
+extern int QR_FindBitTransitions(const uint64_t *row, int width, int *edges);
+
+/*Find the colour transitions along column x between rows y0 and y0 + n.
+  edges receives the positions relative to y0, like QR_FindTransitions.
+  Return: The number of transitions found.*/
+extern int QR_FindBitColumnTransitions(const uint64_t *bits, int words, int x, int y0, int n, int *edges);
+
+/*Find the positions where two bitmap rows differ, like QR_FindChanges.
+  Return: The number of positions found.*/
+extern int QR_FindBitChanges(const uint64_t *a, const uint64_t *b, int words, int *out);
+
+//展开成每像素1字节，白色为0xFF，黑色为0
+extern void QR_UnpackBits(const uint64_t *bits, int words, int width, int height, unsigned char *dst, int step);
+
+#endif
@@ -1,10 +1,15 @@
+#include <opencv2/core/core.hpp>
+
 #include <iostream>
 #include "zbar.h"
-#include "decoder.h"
 
+using namespace cv;
 using namespace std;
 using namespace zbar;
 
+#include "decoder.h"
+#include "payload.h"
+
 ImageScanner g_scanner;
 
 void QR_CreateDecoder(void)
@@ -13,7 +18,7 @@ void QR_CreateDecoder(void)
     return;
 }
 
-void QR_Decode(unsigned char* data, int width, int height)
+int QR_Decode(unsigned char* data, int width, int height)
 {
 	Image image(width, height, "Y800", data, width * height);
 
@@ -32,7 +37,25 @@ void QR_Decode(unsigned char* data, int width, int height)
     // clean up
     image.set_data(NULL, 0);
 
-    return;
+    return n;
+}
+
+int QR_DecodeCode(const QRCodeGrid *grid, unsigned char* data, int width, int height)
+{
+	//和g_scanner一样只在一个线程上使用
+	static QRPayload payload;
+
+	//zbar要在裁剪出的图像中重新寻找finder，grid能解出时就不再交给它
+	if (NULL != grid && QR_PAYLOAD_OK == QR_DecodePayload(grid, &payload)){
+		cout << "decoded QR-Code symbol \"" << payload.data << '"' << endl;
+		return QR_DECODE_NATIVE;
+	}
+
+	if (NULL == data || QR_Decode(data, width, height) <= 0){
+		return QR_DECODE_NONE;
+	}
+
+	return QR_DECODE_ZBAR;
 }
 
 
@@ -1,8 +1,25 @@
 #ifndef _DECODER_H_
 #define _DECODER_H_
 
+struct QRCodeGrid;
+
+//QR_DecodeCode由哪一方解出
+enum{
+	QR_DECODE_NONE = -1,
+	QR_DECODE_NATIVE = 0, //从grid直接解出
+	QR_DECODE_ZBAR = 1,   //zbar在裁剪的图像中解出
+};
+
 void QR_CreateDecoder(void);
-void QR_Decode(unsigned char* data, int width, int height);
 
-#endif
+//用zbar扫描整幅图像，返回解出的二维码个数
+int QR_Decode(unsigned char* data, int width, int height);
 
+/*Decode one located code: its module grid with the built-in decoder (see
+   payload.h) first, and only when that fails its crop with zbar, which
+   searches the crop for finders again.
+  grid may be NULL when the locator did not sample one, data is the crop.
+  Return: QR_DECODE_xxx.*/
+int QR_DecodeCode(const struct QRCodeGrid *grid, unsigned char* data, int width, int height);
+
+#endif
@@ -4,7 +4,10 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <set>
@@ -14,187 +17,44 @@ using namespace cv;
 using namespace std;
 
 #include "locator.h"
+#include "transition.h"
+#include "transpose.h"
+#include "threshold.h"
+#include "bitmap.h"
 
 #define QR_COLOR_WHITE 0xFF
 #define QR_COLOR_BLACK 0x00
 
 #define QR_TO_ACTUAL(cor) ((cor) >> QR_FINDER_SUBPREC)
 #define QR_TO_CALC(cor)   ((cor) << QR_FINDER_SUBPREC)
+#define QR_TO_ACTUAL_F(cor) ((cor) / (double)(1 << QR_FINDER_SUBPREC))
 
+//带上执行的扫描任务
 enum{
-	FIND_STATE_INIT = 0, //wait for white separacter
-	FIND_STATE_1,        //wait for black
-	FIND_STATE_2,		 //wait for white
-	FIND_STATE_3,        //wait for black
-	FIND_STATE_4,        //wait for white
-	FIND_STATE_5,        //wait for black
-	FIND_STATE_6,        //wait for white
-	FIND_STATE_FINISH,
+	QR_SCANJOB_ROWS = 0,   //逐行扫描
+	QR_SCANJOB_PROBE,      //隔行试探
+	QR_SCANJOB_MARKED,     //扫描标记过的行
+	QR_SCANJOB_STRIDED,
+	QR_SCANJOB_TRANSPOSED,
+	QR_SCANJOB_TARGETED,
+	QR_SCANJOB_ROWMAJOR,
+	QR_SCANJOB_SHRINK,     //金字塔缩小
+	QR_SCANJOB_GRAY,
+	QR_SCANJOB_THRESHOLD,
+	QR_SCANJOB_DILATE,
+	QR_SCANJOB_ERODE
 };
 
-//point
-typedef int QRPoint[2];
-
-
-//ƥ::::::׵ģʽȱΪn:1:1:3:1:1:n
-typedef struct QRFindState{
-	int w[5];
-	int last;
-	char stage;
-}QRFindState;
-
-//ѰҵĴfinderߣȷx򣬻y
-
-/*A line crossing a finder pattern.
-  Whether the line is horizontal or vertical is determined by context.
-  The offsts to various parts of the finder pattern are as follows:
-    |*****|     |*****|*****|*****|     |*****|
-    |*****|     |*****|*****|*****|     |*****|
-       ^        ^                 ^        ^
-       |        |                 |        |
-       |        |                 |       pos[v]+len+eoffs
-       |        |                pos[v]+len
-       |       pos[v]
-      pos[v]-boffs
-  Here v is 0 for horizontal and 1 for vertical lines.*/
-typedef struct QRFinderLine{
-  /*The location of the upper/left endpoint of the line.
-    The left/upper edge of the center section is used, since other lines must
-     cross in this region.*/
-  QRPoint pos;
-  /*The length of the center section.
-    This extends to the right/bottom of the center section, since other lines
-     must cross in this region.*/
-  int      len;
-  /*The offset to the midpoint of the upper/left section (part of the outside
-     ring), or 0 if we couldn't identify the edge of the beginning section.
-    We use the midpoint instead of the edge because it can be located more
-     reliably.*/
-  int      boffs;
-  /*The offset to the midpoint of the end section (part of the outside ring),
-     or 0 if we couldn't identify the edge of the end section.
-    We use the midpoint instead of the edge because it can be located more
-     reliably.*/
-  int      eoffs;
-} QRFinderLine;
-
-/*A cluster of lines crossing a finder pattern (all in the same direction).*/
-typedef struct QRFinderCluster{
-  /*Pointers to the lines crossing the pattern.*/
-  QRFinderLine **lines;
-  /*The number of lines in the cluster.*/
-  int          nlines;
-} QRFinderCluster;
-
-typedef struct QRFinderCenter{
-	QRPoint pos; //finder ĵλ
-	int     len; //finder ĺڿĿ
-} QRFinderCenter;
-
 const Scalar g_Green = Scalar(0, 255, 0);
 const Scalar g_Red = Scalar(0, 0, 255);
 
-//ͼƬѰfinder lineʱʹ
-static QRFinderLine g_XLines[QR_CONFIG_MAX_FINDER_LINE];
-static int g_XLineSize = 0;
-static QRFinderLine g_YLines[QR_CONFIG_MAX_FINDER_LINE];
-static int g_YLineSize = 0;
-
-//cluster lines ʹ
-static char g_LineMark[QR_CONFIG_MAX_FINDER_LINE];
-static QRFinderLine* g_XNeighbors[QR_CONFIG_MAX_FINDER_LINE];
-static QRFinderLine* g_YNeighbors[QR_CONFIG_MAX_FINDER_LINE];
-static QRFinderCluster g_XClusters[QR_CONFIG_MAX_FINDER_LINE/2];
-static int g_nXClusters;
-static QRFinderCluster g_YClusters[QR_CONFIG_MAX_FINDER_LINE/2];
-static int g_nYClusters;
-
-//cross clusters ʹ
-static QRFinderCluster* g_XCNeighbors[QR_CONFIG_MAX_FINDER_LINE/2];
-static QRFinderCluster* g_YCNeighbors[QR_CONFIG_MAX_FINDER_LINE/2];
-
-//finder centerʹ
-static QRFinderCenter g_Centers[QR_CONFIG_MAX_FINDER_CENTER];
-static int g_nCenters = 0;
-
 static void _drawFinderLines(Mat &img, QRFinderLine* lines, int lsize, int _v);
 
-static void _addStage(int pos, int color, QRFindState *state)
-{
-	//if already in FIND_STATE_FINISH state, means current state is not a valid finder line
-	//so we discard fist two width( finder pattern always start with a black)
-	if (FIND_STATE_FINISH == state->stage){
-		state->w[0] = state->w[2];
-		state->w[1] = state->w[3];
-		state->w[2] = state->w[4];
-		state->stage = FIND_STATE_5;
-	}
-	
-	pos = QR_TO_CALC(pos);
-	
-	switch (state->stage){
-		case FIND_STATE_INIT:
-			if (QR_COLOR_WHITE == color){
-				state->stage = FIND_STATE_1;
-			}
-			break;
-		case FIND_STATE_1:
-			if (QR_COLOR_BLACK == color){
-				state->stage = FIND_STATE_2;
-				state->last = pos;
-			}
-			break;
-		case FIND_STATE_2:
-			if (QR_COLOR_WHITE == color){
-				state->w[0] = pos - state->last;
-				state->last = pos;
-				state->stage = FIND_STATE_3;
-			}
-			break;
-		case FIND_STATE_3:
-			if (QR_COLOR_BLACK == color){
-				state->w[1] = pos - state->last;
-				state->last = pos;
-				state->stage = FIND_STATE_4;
-			}
-			break;
-		case FIND_STATE_4:
-			if (QR_COLOR_WHITE == color){
-				state->w[2] = pos - state->last;
-				state->last = pos;
-				state->stage = FIND_STATE_5;
-			}
-			break;
-		case FIND_STATE_5:
-			if (QR_COLOR_BLACK == color){
-				state->w[3] = pos - state->last;
-				state->last = pos;
-				state->stage = FIND_STATE_6;
-			}
-			break;
-		case FIND_STATE_6:
-			if (QR_COLOR_WHITE == color){
-				state->w[4] = pos - state->last;
-				state->last = pos;
-				state->stage = FIND_STATE_FINISH;
-			}
-			break;
-		default:
-			memset(state, 0, sizeof(*state));
-			assert(0);
-			break;
-	};
-}
-
 static int _matchState(QRFindState *state)
 {
 	int unit;
 	int half;
 	
-	if (FIND_STATE_FINISH != state->stage){
-		return 0;
-	}
-	
 	unit = (state->w[0] + state->w[1] + state->w[2] +state->w[3] + state->w[4])/7;
 	half = unit/2;
 	
@@ -209,514 +69,3531 @@ static int _matchState(QRFindState *state)
 	}
 }
 
-static void _addXFinderLine(int y, QRFindState *state)
+//根据匹配到的5段宽度填写finder line，fixed是另一个方向上的坐标
+static void _fillFinderLine(QRFinderLine *fline, int fixed, QRFindState *state, int _v)
 {
-	QRFinderLine *fline;
-
-	if (g_XLineSize >= QR_CONFIG_MAX_FINDER_LINE){
-		ASSERT(0);
-		return;
-	}
-
-	fline = g_XLines + g_XLineSize;
-	g_XLineSize += 1;
-
-	fline->pos[0] = (state->last - state->w[2] - state->w[3] - state->w[4]);
-	fline->pos[1] = QR_TO_CALC(y);
+	fline->pos[_v] = (state->last - state->w[2] - state->w[3] - state->w[4]);
+	fline->pos[1-_v] = QR_TO_CALC(fixed);
 	fline->len = state->w[2];
 	fline->boffs = state->w[1] + state->w[0]/2;
 	fline->eoffs = state->w[3] + state->w[4]/2;
-	
+
 	return;
 }
 
-static void _addYFinderLine(int x, QRFindState *state)
+/*Make room for need bytes in a growable buffer, doubling it when it is full.
+  The first used bytes are kept. Bands fill their buffers from the worker
+   threads, so the allocation counter is updated atomically.*/
+void* QRLocator::_growBuffer(Mat &buf, size_t used, size_t need)
 {
-	QRFinderLine *fline;
+	Mat grown;
+	size_t cap;
+
+	cap = buf.total();
+	if (need > cap){
+		cap = MAX(need, MAX((size_t)1024, cap * 2));
+		grown.create(1, (int)cap, CV_8UC1);
+		if (used > 0){
+			memcpy(grown.data, buf.data, used);
+		}
+		buf = grown;
+		__sync_fetch_and_add(&m_nAllocs, 1);
+	}
 
-	if (g_YLineSize >= QR_CONFIG_MAX_FINDER_LINE){
-		ASSERT(0);
-		return;
+	return buf.data;
+}
+
+//保证buf能放下need条线
+QRFinderLine* QRLocator::_growLines(Mat &buf, int used, int need)
+{
+	return (QRFinderLine *)_growBuffer(buf, used * sizeof(QRFinderLine), need * sizeof(QRFinderLine));
+}
+
+//在带的末尾加一条线
+QRFinderLine* QRLocator::_pushLine(QRScanBand *band)
+{
+	QRFinderLine *lines;
+
+	lines = _growLines(band->lines, band->nlines, band->nlines + 1);
+
+	return lines + band->nlines++;
+}
+
+//一条线在分组中的状态，也是以它开始的链的状态
+typedef struct QRLineLink{
+	int  parent;        //接上的下一条线，-1表示它是链的最后一条线
+	int  count;         //到parent为止的线数和长度之和，不含parent
+	int  len;
+	int  next;          //链中的下一条线
+	int  cell;          //作为最后一条线所在的格子，不在索引中时为-1
+	int  prev;          //同一格子中的前后两条线
+	int  after;
+	char mark;          //已经属于某个cluster
+} QRLineLink;
+
+void QRLocator::_clusterBegin(QRClusterBuilder *b, int _v)
+{
+	b->_v = _v;
+	b->nlines = 0;
+	b->fixed = 0;
+	b->maxThresh = 0;
+	b->head = 0;
+	b->ncells = 0;
+	b->nmembers = 0;
+	b->nclusters = 0;
+}
+
+//从所在格子的链表中取出
+static void _unlinkLine(QRClusterBuilder *b, int k)
+{
+	QRLineLink *links;
+	int *cells;
+
+	links = (QRLineLink *)b->links.data;
+	cells = (int *)b->cells.data;
+	if (links[k].prev >= 0){
+		links[links[k].prev].after = links[k].after;
+	} else {
+		cells[links[k].cell] = links[k].after;
 	}
-	
-	fline = g_YLines + g_YLineSize;
-	g_YLineSize += 1;
+	if (links[k].after >= 0){
+		links[links[k].after].prev = links[k].prev;
+	}
+	links[k].cell = -1;
+}
+
+//把线k放进格子cell
+void QRLocator::_linkLine(QRClusterBuilder *b, int k, int cell)
+{
+	QRLineLink *links;
+	int *cells;
+	int i;
+
+	cells = (int *)_growBuffer(b->cells, b->ncells * sizeof(int), (cell + 1) * sizeof(int));
+	for (i = b->ncells; i <= cell; ++i){
+		cells[i] = -1;
+	}
+	b->ncells = MAX(b->ncells, cell + 1);
+
+	links = (QRLineLink *)b->links.data;
+	links[k].cell = cell;
+	links[k].prev = -1;
+	links[k].after = cells[cell];
+	if (cells[cell] >= 0){
+		links[cells[cell]].prev = k;
+	}
+	cells[cell] = k;
 
-	fline->pos[0] = QR_TO_CALC(x);
-	fline->pos[1] = (state->last - state->w[2] - state->w[3] - state->w[4]);	
-	fline->len = state->w[2];
-	fline->boffs = state->w[1] + state->w[0]/2;
-	fline->eoffs = state->w[3] + state->w[4]/2;
-	
 	return;
 }
 
-static void _resetState(QRFindState *state)
+/*Whether the scan has left the chains ending in line k: the last line added
+   is more than the threshold of line k away across the lines.
+  Lines arrive sorted by that coordinate, so chains that were left are never
+   reached again.*/
+static int _linePassed(const QRClusterBuilder *b, int k)
 {
-	memset(state, 0, sizeof(*state));
+	const QRFinderLine *a;
+
+	a = (const QRFinderLine *)b->lines.data + k;
+
+	return abs(b->fixed - a->pos[1-b->_v]) > ((a->len + 7) >> 2);
 }
 
-static void _scanImage(Mat &binary)
+/*Find the last line of the chain started by line i, compressing the path.
+  count and len receive the number and the total length of the lines of the
+   chain before the last one.*/
+static int _findLast(QRClusterBuilder *b, int i, int *count, int *len)
 {
-	unsigned char *raw;
-	unsigned char pixel;
-	int x;
-	int y;
-	int width;
-	int height;
-	int ret;
-	QRFindState state;
-	
-	CV_Assert(true == binary.isContinuous());
-	width = binary.cols;
-	height = binary.rows;
-	raw = binary.ptr<uchar>(0);
-
-	for (y = 0; y < height; ++y){
-		
-		_resetState(&state);
-		for (x = 0; x < width; ++x){
-			
-			pixel = raw[y * width + x];
-			_addStage(x, pixel, &state);
-				
-			//test if we find the marker
-			ret = _matchState(&state);
-			if (1 == ret){
-				_addXFinderLine(y, &state);
-			}
-		}//for
-	}//for
-	
-	for (x = 0; x < width; ++x){
-		
-		_resetState(&state);
-		for (y = 0; y < height; ++y){
-			
-			pixel = raw[y * width + x];
-			_addStage(y, pixel, &state);
-
-			//test if we find the marker
-			ret = _matchState(&state);
-			if (1 == ret){
-				_addYFinderLine(x, &state);
-			} 
-		}//for
-	}//for
-	
-	return;
+	QRLineLink *links;
+	int root;
+	int n;
+	int l;
+	int c;
+	int k;
+	int p;
+
+	links = (QRLineLink *)b->links.data;
+	n = 0;
+	l = 0;
+	for (root = i; links[root].parent >= 0; root = links[root].parent){
+		n += links[root].count;
+		l += links[root].len;
+	}
+	*count = n;
+	*len = l;
+
+	//路径上的线都直接指向最后一条线
+	for (k = i; k != root; k = p){
+		p = links[k].parent;
+		c = links[k].count;
+		links[k].parent = root;
+		links[k].count = n;
+		n -= c;
+		c = links[k].len;
+		links[k].len = l;
+		l -= c;
+	}
+
+	return root;
 }
 
-//˵ߣmarkerline飬ÿɳ
-static int _clusterLines(QRFinderLine *lines, int nline, QRFinderLine** neighbors, QRFinderCluster *cluster, int _v)
+/*Add the next line in scan order.
+  The line is compared with the last line of each open chain in reach, with
+   the same tests the lines of a cluster always had to pass, and continues
+   every chain that passes.*/
+void QRLocator::_clusterAdd(QRClusterBuilder *b, const QRFinderLine *line)
 {
-	int i;
-	int j;
-	int nneighbors;
-	int nclusters;
+	QRFinderLine *lines;
 	QRFinderLine *a;
-	QRFinderLine *b;
+	QRLineLink *links;
+	int *cells;
+	int _v;
+	int idx;
 	int thresh;
-	int len;
-
-	nclusters = 0;
-	len = 0;
-	memset(g_LineMark, 0, sizeof(g_LineMark));
-	for (i = 0; i < nline; ++i){
-		if (0 != g_LineMark[i]){
-			continue;
-		}
-
-		nneighbors = 0;
-		neighbors[nneighbors++] = lines + i;
-		len = neighbors[nneighbors - 1]->len;
-		
-		for (j = i + 1; j < nline; ++j){
-			if (0 != g_LineMark[i]){
+	int after;
+	int last;
+	int j;
+	int k;
+
+	_v = b->_v;
+	ASSERT(0 == b->nlines || line->pos[1-_v] >= b->fixed);
+	idx = b->nlines;
+	lines = _growLines(b->lines, idx, idx + 1);
+	lines[idx] = *line;
+	links = (QRLineLink *)_growBuffer(b->links, idx * sizeof(QRLineLink), (idx + 1) * sizeof(QRLineLink));
+	links[idx].parent = -1;
+	links[idx].count = 0;
+	links[idx].len = 0;
+	links[idx].next = -1;
+	links[idx].cell = -1;
+	links[idx].mark = 0;
+	b->nlines += 1;
+	b->fixed = line->pos[1-_v];
+	b->maxThresh = MAX(b->maxThresh, (line->len + 7) >> 2);
+
+	//只有最后一条线离得足够近的链才可能接上
+	cells = (int *)b->cells.data;
+	last = MIN(b->ncells - 1, (line->pos[_v] + b->maxThresh) >> QR_CONFIG_CLUSTER_CELL_SHIFT);
+	for (k = MAX(0, line->pos[_v] - b->maxThresh) >> QR_CONFIG_CLUSTER_CELL_SHIFT; k <= last; ++k){
+		for (j = cells[k]; j >= 0; j = after){
+			after = links[j].after;
+			if (_linePassed(b, j)){
+				_unlinkLine(b, j);
 				continue;
 			}
 
-			a = neighbors[nneighbors - 1];
-			b = lines + j;
-
-			thresh=a->len+7>>2;
-			if(abs(a->pos[1-_v]-b->pos[1-_v])>thresh)break;
-			if(abs(a->pos[_v]-b->pos[_v])>thresh)continue;
-			if(abs(a->pos[_v]+a->len-b->pos[_v]-b->len)>thresh)continue;
-			if(a->boffs>0&&b->boffs>0&&
-			 abs(a->pos[_v]-a->boffs-b->pos[_v]+b->boffs)>thresh){
+			a = lines + j;
+			thresh = (a->len + 7) >> 2;
+			if(abs(a->pos[_v]-line->pos[_v])>thresh)continue;
+			if(abs(a->pos[_v]+a->len-line->pos[_v]-line->len)>thresh)continue;
+			if(a->boffs>0&&line->boffs>0&&
+			 abs(a->pos[_v]-a->boffs-line->pos[_v]+line->boffs)>thresh){
 			  continue;
 			}
-			if(a->eoffs>0&&b->eoffs>0&&
-			 abs(a->pos[_v]+a->len+a->eoffs-b->pos[_v]-b->len-b->eoffs)>thresh){
+			if(a->eoffs>0&&line->eoffs>0&&
+			 abs(a->pos[_v]+a->len+a->eoffs-line->pos[_v]-line->len-line->eoffs)>thresh){
 			  continue;
 			}
 
-			neighbors[nneighbors++] = lines + j;
-			ASSERT(nneighbors < QR_CONFIG_MAX_FINDER_LINE);
-			len += b->len;
-		}
-
-		if (nneighbors < 3){
-			continue;
-		}
-
-		len = ((len<<1)+nneighbors)/(nneighbors<<1);
-		if (QR_TO_CALC(nneighbors)*5 >= len){
-			cluster[nclusters].lines = neighbors;
-			cluster[nclusters].nlines = nneighbors;
-			for(j=0;j<nneighbors;j++)g_LineMark[neighbors[j]-lines]=1;
-			neighbors += nneighbors;
-			nclusters += 1;
-			ASSERT(nclusters < QR_CONFIG_MAX_FINDER_LINE/2);
+			//以j结尾的链都接上这条线，并入以它开始的链
+			_unlinkLine(b, j);
+			links[j].parent = idx;
+			links[j].count = 1;
+			links[j].len = a->len;
+			links[j].next = idx;
 		}
 	}
 
-	return nclusters;
-}
+	_linkLine(b, idx, MAX(0, line->pos[_v]) >> QR_CONFIG_CLUSTER_CELL_SHIFT);
+	_resolveChains(b, 0);
 
-/*Determine if a horizontal line crosses a vertical line.
-  _hline: The horizontal line.
-  _vline: The vertical line.
-  Return: A non-zero value if the lines cross, or zero if they do not.*/
-static int _linesAreCrossing(const QRFinderLine *_hline,
- const QRFinderLine *_vline){
-  return
-   _hline->pos[0]<=_vline->pos[0]&&_vline->pos[0]<_hline->pos[0]+_hline->len&&
-   _vline->pos[1]<=_hline->pos[1]&&_hline->pos[1]<_vline->pos[1]+_vline->len;
+	return;
 }
 
-static void _calcMiddleLine(QRFinderCluster** clusters, int nCluster, int _v, QRFinderLine* line)
+/*Turn the closed chains at the front into clusters, in the order they were
+   started, until an open one is reached, or all of them when final is set.
+  A chain whose first line already belongs to a cluster is dropped; the
+   others are kept with at least 3 lines that are not too far apart for
+   their length, and their lines are marked.*/
+void QRLocator::_resolveChains(QRClusterBuilder *b, int final)
 {
-	QRFinderCluster* c;
-	int i;
-	int j;
+	QRFinderLine *lines;
+	QRLineLink *links;
+	int *members;
+	int *spans;
+	int root;
 	int len;
-	int start;
-	int count;
-	int min;
-	int max;
-
-	start = 0;
-	len = 0;
-	count = 0;
-	min = 0x7FFFFFFF;
-	max = 0;
-	for (i = 0; i < nCluster; ++i){
-		c = clusters[i];
-		for (j = 0; j < c->nlines; ++j){
-			start += c->lines[j]->pos[_v];
-			len += c->lines[j]->len;
-			count += 1;
-
-			if (c->lines[j]->pos[1-_v] > max){
-				max = c->lines[j]->pos[1-_v];
-			}
-
-			if (c->lines[j]->pos[1-_v] < min){
-				min = c->lines[j]->pos[1-_v];
+	int n;
+	int i;
+	int k;
+
+	lines = (QRFinderLine *)b->lines.data;
+	links = (QRLineLink *)b->links.data;
+	while (b->head < b->nlines){
+		i = b->head;
+		root = _findLast(b, i, &n, &len);
+		if (!final && links[root].cell >= 0 && !_linePassed(b, root)){
+			break;
+		}
+		n += 1;
+		len += lines[root].len;
+
+		if (0 == links[i].mark && n >= 3){
+			len = ((len<<1)+n)/(n<<1);
+			if (QR_TO_CALC(n)*5 >= len){
+				members = (int *)_growBuffer(b->members, b->nmembers * sizeof(int), (b->nmembers + n) * sizeof(int));
+				spans = (int *)_growBuffer(b->spans, b->nclusters * 2 * sizeof(int), (b->nclusters + 1) * 2 * sizeof(int));
+				spans[2 * b->nclusters] = b->nmembers;
+				spans[2 * b->nclusters + 1] = n;
+				b->nclusters += 1;
+				for (k = i; k >= 0; k = links[k].next){
+					members[b->nmembers++] = k;
+					links[k].mark = 1;
+				}
 			}
 		}
+		b->head += 1;
 	}
 
-	line->pos[_v] = (start + (count >> 2))/count;
-	line->pos[1-_v] = (min + max + 1)/2;
-	line->len = (len + (count >> 2))/count;
-	line->boffs = 0;
-	line->eoffs = 0;
-	
 	return;
 }
 
-static int _findCrossing(QRFinderCenter *centers, int centerSize, 
-						  QRFinderCluster* xClusters, int nxCluster, 
-						  QRFinderCluster* yClusters, int nyCluster,
-						  QRFinderCluster** xNeighbors,
-						  QRFinderCluster** yNeighbors)
+/*Close the remaining chains and build the clusters.
+  The lines of each cluster are copied next to each other, so a cluster is a
+   range of that array and is read without following pointers.
+  The results point into the builder and stay valid until it is begun again.
+  Return: The number of clusters.*/
+int QRLocator::_clusterEnd(QRClusterBuilder *b, QRFinderLine **lines, int *nlines, QRFinderCluster **clusters)
 {
-	int i;
-	int j;
-	char *xMark = g_LineMark;
-	char *yMark = g_LineMark + QR_CONFIG_MAX_FINDER_LINE/2;
-	QRFinderLine *a;
-	QRFinderLine *b;
-	QRFinderLine xMiddleLine;
-	QRFinderLine yMiddleLine;
-	int nxNeighbors;	
-	int nyNeighbors;
-	int nCenters;
+	QRFinderCluster *out;
+	QRFinderLine *grouped;
+	QRFinderLine *base;
+	int *members;
+	int *spans;
+	int k;
+
+	_resolveChains(b, 1);
+
+	base = (QRFinderLine *)b->lines.data;
+	members = (int *)b->members.data;
+	spans = (int *)b->spans.data;
+	grouped = _growLines(b->grouped, 0, MAX(1, b->nmembers));
+	out = (QRFinderCluster *)_growBuffer(b->clusters, 0, MAX(1, b->nclusters) * sizeof(QRFinderCluster));
+	for (k = 0; k < b->nmembers; ++k){
+		grouped[k] = base[members[k]];
+	}
+	for (k = 0; k < b->nclusters; ++k){
+		out[k].lines = grouped + spans[2 * k];
+		out[k].nlines = spans[2 * k + 1];
+	}
 
-	memset(g_LineMark, 0 ,sizeof(g_LineMark));
-	nCenters = 0;
-	
-	for (i = 0; i < nxCluster; ++i){
-		if (1 == xMark[i]){
-			continue;
-		}
+	*lines = base;
+	*nlines = b->nlines;
+	*clusters = out;
 
-		nyNeighbors = 0;
-		a = xClusters[i].lines[xClusters[i].nlines>>1];
-		for (j = 0; j < nyCluster; ++j){
-			if (1 == yMark[j]){
-				continue;
-			}
+	return b->nclusters;
+}
 
-			b = yClusters[j].lines[yClusters[j].nlines>>1];
-			if (_linesAreCrossing(a, b)){
-				yMark[j],
-				yNeighbors[nyNeighbors++] = yClusters + j;
-			}
-		}
+//把带中的线交给cluster
+void QRLocator::_feedBand(QRScanBand *band)
+{
+	QRFinderLine *lines;
+	int i;
 
-		if (nyNeighbors > 0){
-			_calcMiddleLine(yNeighbors, nyNeighbors, 1, &yMiddleLine);
-			nxNeighbors = 0;
-			xNeighbors[nxNeighbors++] = xClusters+i;
-			
-			for (j = i + 1; j < nxCluster; ++j){
-				if (1 == xMark[i]){
-					continue;
-				}
+	lines = (QRFinderLine *)band->lines.data;
+	for (i = 0; i < band->nlines; ++i){
+		_clusterAdd(band->feed, lines + i);
+	}
+	band->nlines = 0;
 
-				a = xClusters[j].lines[xClusters[j].nlines>>1];
-				if (_linesAreCrossing(a, &yMiddleLine)){
-					xMark[j]=1;
-					xNeighbors[nxNeighbors++] = xClusters + j;
-				}
-			}
+	return;
+}
 
-			_calcMiddleLine(xNeighbors, nxNeighbors, 0, &xMiddleLine);
+/*Add the lines of the bands to b in band order, which is the order of one
+   serial scan.*/
+void QRLocator::_joinBands(int nbands, QRClusterBuilder *b)
+{
+	QRScanBand *band;
+	int i;
 
-			if (nCenters < centerSize){
-				centers[nCenters].pos[0] = yMiddleLine.pos[0];
-				centers[nCenters].pos[1] = xMiddleLine.pos[1];
-				centers[nCenters].len = (yMiddleLine.len + xMiddleLine.len) / 2;
-				nCenters += 1;
-			} else {
-				ASSERT(0);
-			}
-		}
+	for (i = 0; i < nbands; ++i){
+		band = m_Bands + i;
+		band->feed = b;
+		_feedBand(band);
+		m_nScannedRows += band->scannedRows;
+		m_nScannedPixels += band->scannedPixels;
 	}
 
-	return nCenters;
+	return;
 }
 
-static void _drawXFinderLine(Mat &img, QRFinderLine *line)
+//(x, y)处的像素是否为黑色
+static int _isBlack(const QRBinaryImage *img, int x, int y)
 {
-	cv::line(img, 
-			 Point(QR_TO_ACTUAL(line->pos[0] - line->boffs), QR_TO_ACTUAL(line->pos[1])), 
-			 Point(QR_TO_ACTUAL(line->pos[0] + line->len + line->eoffs), QR_TO_ACTUAL(line->pos[1])), 
-			 g_Green);
+	if (NULL != img->bits){
+		return 0 == ((img->bits[(size_t)y * img->words + (x >> 6)] >> (x & 63)) & 1);
+	}
 
-	return;
+	return QR_COLOR_BLACK == img->bytes[(size_t)y * img->width + x];
 }
 
-static void _drawYFinderLine(Mat &img, QRFinderLine *line)
+//第y行的跳变
+static int _rowTransitions(const QRBinaryImage *img, int y, int *edges)
 {
-	cv::line(img, 
-			Point(QR_TO_ACTUAL(line->pos[0]), QR_TO_ACTUAL(line->pos[1] - line->boffs)), 
-			Point(QR_TO_ACTUAL(line->pos[0]), QR_TO_ACTUAL(line->pos[1] + line->len + line->eoffs)),
-			g_Green);
+	if (NULL != img->bits){
+		return QR_FindBitTransitions(img->bits + (size_t)y * img->words, img->width, edges);
+	}
 
-	return;
+	return QR_FindTransitions(img->bytes + (size_t)y * img->width, img->width, 1, edges);
 }
 
-//finder line
-static void _drawFinderLines(Mat &img, QRFinderLine* lines, int lsize, int _v)
+//第x列从y0开始n个像素中的跳变，位置相对于y0
+static int _columnTransitions(const QRBinaryImage *img, int x, int y0, int n, int *edges)
+{
+	if (NULL != img->bits){
+		return QR_FindBitColumnTransitions(img->bits, img->words, x, y0, n, edges);
+	}
+
+	return QR_FindTransitions(img->bytes + (size_t)y0 * img->width + x, n, img->width, edges);
+}
+
+/*The columns in [x0, x1) where row y-1 and row y differ.
+  For a bitmap x0 must be a multiple of 64.*/
+static int _rowChanges(const QRBinaryImage *img, int y, int x0, int x1, int *cols)
 {
+	int ncols;
+	int k0;
 	int i;
 
-	printf("find [%d] lines.\r\n", lsize);
+	if (NULL != img->bits){
+		k0 = x0 >> 6;
+		ncols = QR_FindBitChanges(img->bits + (size_t)(y - 1) * img->words + k0,
+		                          img->bits + (size_t)y * img->words + k0, QR_BITMAP_WORDS(x1) - k0, cols);
+	} else {
+		ncols = QR_FindChanges(img->bytes + (size_t)(y - 1) * img->width + x0,
+		                       img->bytes + (size_t)y * img->width + x0, x1 - x0, cols);
+	}
 
-	for (i = 0; i < lsize; ++i){
-		if (0 == _v){
-			_drawXFinderLine(img, lines + i);
-		} else {
-			_drawYFinderLine(img, lines + i);
+	if (x0 > 0){
+		for (i = 0; i < ncols; ++i){
+			cols[i] += x0;
 		}
 	}
 
-	return;
+	return ncols;
 }
 
-//cluster
-static void _drawCluster(Mat &img, QRFinderCluster *cluster, int clusterSize, int _v)
+/*Merge every run shorter than minRun into its neighbours.
+  The transitions are walked in order and a transition closer than minRun to
+   the last one kept removes both, so the short run and the two runs around
+   it become one run of the neighbours' colour.
+  Transitions always go away in pairs, so the colour at edges[0] does not
+   change and kept transitions are at least minRun apart.
+  Return: The number of transitions kept.*/
+static int _mergeShortRuns(int *edges, int nedges, int minRun)
 {
+	int nkept;
 	int i;
-	int j;
 
-	for (i = 0; i < clusterSize; ++i){
-		for (j = 0; j < cluster->nlines; ++j){
-			if (0 == _v){
-				_drawXFinderLine(img, cluster->lines[j]);
-			} else {
-				_drawYFinderLine(img, cluster->lines[j]);
-			}
+	nkept = 0;
+	for (i = 0; i < nedges; ++i){
+		if (nkept > 0 && edges[i] - edges[nkept - 1] < minRun){
+			nkept -= 1;
+		} else {
+			edges[nkept++] = edges[i];
 		}
-		cluster += 1;
 	}
 
-	return;
+	return nkept;
 }
 
-static void _drawCenters(Mat &img, QRFinderCenter *centers, int nCenters)
+/*Run the 1:1:3:1:1 test over the transitions of one line.
+  Every window of five runs black:white:black:white:black is tested, as long
+   as the first black run follows a white pixel on the same line and the last
+   one is closed by a white pixel.
+  black tells whether the pixel at edges[0] is black.
+  Runs shorter than min_run_px are merged first, edges is modified.
+  _v: 0 for a row at y = fixed, 1 for a column at x = fixed.*/
+void QRLocator::_scanRuns(QRScanBand *band, int *edges, int nedges, int black, int fixed, int _v)
 {
+	QRFindState state;
 	int i;
+	int k;
 
-	for (i = 0; i < nCenters; ++i){
+	if (m_Config.min_run_px > 1){
+		nedges = _mergeShortRuns(edges, nedges, m_Config.min_run_px);
+	}
 
-		cv::line(img, 
-				 Point(QR_TO_ACTUAL(centers[i].pos[0]) - 3, QR_TO_ACTUAL(centers[i].pos[1])), 
-				 Point(QR_TO_ACTUAL(centers[i].pos[0]) + 3, QR_TO_ACTUAL(centers[i].pos[1])),
-				 g_Red);
+	//第一个黑块必须紧跟在跳变之后，也就是前面有白色像素
+	i = black ? 0 : 1;
+	for (; i + 5 < nedges; i += 2){
+		for (k = 0; k < 5; ++k){
+			state.w[k] = QR_TO_CALC(edges[i + k + 1] - edges[i + k]);
+		}
+		state.last = QR_TO_CALC(edges[i + 5]);
 
-		cv::line(img, 
-				 Point(QR_TO_ACTUAL(centers[i].pos[0]), QR_TO_ACTUAL(centers[i].pos[1]) - 3), 
-				 Point(QR_TO_ACTUAL(centers[i].pos[0]), QR_TO_ACTUAL(centers[i].pos[1]) + 3),
-				 g_Red);		
+		//test if we find the marker
+		if (1 == _matchState(&state)){
+			_fillFinderLine(_pushLine(band), fixed, &state, _v);
+		}
 	}
 
-	return;
+	if (NULL != band->feed){
+		_feedBand(band);
+	}
+
+	return;
+}
+
+//逐列遍历图像，每列单独找跳变
+void QRLocator::_scanColumnsStrided(QRScanBand *band, const QRBinaryImage *img)
+{
+	int *edges;
+	int nedges;
+	int x;
+
+	edges = (int *)band->edges.data;
+	for (x = band->start; x < band->end; ++x){
+		nedges = _columnTransitions(img, x, 0, img->height, edges);
+		if (nedges > 0){
+			_scanRuns(band, edges, nedges, _isBlack(img, x, edges[0]), x, 1);
+		}
+	}
+
+	return;
+}
+
+/*The image is transposed once before the bands are scanned, the columns
+   are then contiguous rows that can be scanned like the horizontal pass.*/
+void QRLocator::_scanColumnsTransposed(QRScanBand *band, const unsigned char *trans, int height)
+{
+	const unsigned char *line;
+	int *edges;
+	int nedges;
+	int x;
+
+	edges = (int *)band->edges.data;
+	for (x = band->start; x < band->end; ++x){
+		line = trans + (size_t)x * height;
+		nedges = QR_FindTransitions(line, height, 1, edges);
+		if (nedges > 0){
+			_scanRuns(band, edges, nedges, QR_COLOR_BLACK == line[edges[0]], x, 1);
+		}
+	}
+
+	return;
+}
+
+//转置整幅图像，位图需要先展开，转置按字节进行
+const unsigned char* QRLocator::_transposeImage(const QRBinaryImage *img)
+{
+	const unsigned char *raw;
+	unsigned char *bytes;
+	unsigned char *trans;
+
+	raw = img->bytes;
+	if (NULL != img->bits){
+		bytes = _reserveMat(m_UnpackBuf, img->height, img->width, CV_8UC1).data;
+		QR_UnpackBits(img->bits, img->words, img->width, img->height, bytes, img->width);
+		raw = bytes;
+	}
+
+	trans = _reserveMat(m_TransBuf, img->width, img->height, CV_8UC1).data;
+	QR_Transpose8u(raw, img->width, img->height, trans);
+
+	return trans;
+}
+
+//按行遍历列时每列的状态，都是m_ColStateBuf中长度为width+1的数组
+typedef struct QRColumnState{
+	int *hist[5];   //最近5个跳变所在的行
+	int *nseen;     //已经记录的跳变个数，最多6个
+	int *nhits;     //每列匹配到的个数
+	int *pending;   //还能被取消的匹配
+	int *prev;      //移出hist的行
+} QRColumnState;
+
+static void _columnState(int *base, int width, QRColumnState *state)
+{
+	int k;
+
+	for (k = 0; k < 5; ++k){
+		state->hist[k] = base + k * (width + 1);
+	}
+	state->nseen = state->hist[4] + width + 1;
+	state->nhits = state->nseen + width + 1;
+	state->pending = state->nhits + width + 1;
+	state->prev = state->pending + width + 1;
+}
+
+//清空带内各列的状态，m_ColStateBuf必须已经分配
+void QRLocator::_resetColumns(QRScanBand *band, int width)
+{
+	QRColumnState st;
+	int x0;
+	int n;
+
+	_columnState((int *)m_ColStateBuf.data, width, &st);
+	x0 = band->start;
+	n = band->end - band->start;
+	memset(st.nseen + x0, 0, sizeof(int) * n);
+	memset(st.nhits + x0, 0, sizeof(int) * n);
+	memset(st.pending + x0, -1, sizeof(int) * n);
+	band->nhits = 0;
+
+	return;
+}
+
+/*Vertical finder search that walks the image in row order.
+  Each column keeps its last 5 transition rows in structure-of-arrays form;
+   the columns that change between two rows are found with the vector
+   kernels and only those columns are updated.
+  Whenever a column turns from black to white after at least 5 earlier
+   transitions, its last five runs form the same window the strided scan
+   would test.
+  Short runs are merged the same way as _mergeShortRuns does: a transition
+   too close to the last one kept pops it from the history and cancels the
+   match it closed.
+  Kept transitions are at least min_run_px apart, so two pops never follow
+   each other and keeping the row shifted out of the history in prev is
+   enough to undo one.
+  Rows y0 .. y1-1 are compared with the row above; row y is row y - ybase of
+   img, so the state can be carried over strips of a larger image.
+  The state arrays are shared by all bands, each band only touches its own
+   columns.*/
+void QRLocator::_scanColumnRows(QRScanBand *band, const QRBinaryImage *img, int ybase, int y0, int y1)
+{
+	QRFindState state;
+	QRColumnState st;
+	QRFinderLine *hits;
+	int *cols;
+	int minRun;
+	int ncols;
+	int i;
+	int k;
+	int x;
+	int y;
+
+	minRun = m_Config.min_run_px;
+	_columnState((int *)m_ColStateBuf.data, img->width, &st);
+	cols = (int *)band->edges.data;
+
+	for (y = y0; y < y1; ++y){
+		ncols = _rowChanges(img, y - ybase, band->start, band->end, cols);
+		for (i = 0; i < ncols; ++i){
+			x = cols[i];
+
+			//离上一个跳变太近，两个跳变一起去掉
+			if (minRun > 1 && st.nseen[x] > 0 && y - st.hist[4][x] < minRun){
+				st.hist[4][x] = st.hist[3][x];
+				st.hist[3][x] = st.hist[2][x];
+				st.hist[2][x] = st.hist[1][x];
+				st.hist[1][x] = st.hist[0][x];
+				st.hist[0][x] = st.prev[x];
+				st.nseen[x] -= 1;
+				if (st.pending[x] >= 0){
+					//len为0表示已经取消
+					((QRFinderLine *)band->hits.data)[st.pending[x]].len = 0;
+					st.nhits[x] -= 1;
+					st.pending[x] = -1;
+				}
+				continue;
+			}
+
+			//刚结束的是黑块，并且前面已经有5个跳变
+			st.pending[x] = -1;
+			if (st.nseen[x] >= 5 && !_isBlack(img, x, y - ybase)){
+				for (k = 0; k < 4; ++k){
+					state.w[k] = QR_TO_CALC(st.hist[k + 1][x] - st.hist[k][x]);
+				}
+				state.w[4] = QR_TO_CALC(y - st.hist[4][x]);
+				state.last = QR_TO_CALC(y);
+
+				if (1 == _matchState(&state)){
+					st.pending[x] = band->nhits;
+					hits = _growLines(band->hits, band->nhits, band->nhits + 1);
+					_fillFinderLine(hits + band->nhits, x, &state, 1);
+					band->nhits += 1;
+					st.nhits[x] += 1;
+				}
+			}
+
+			if (minRun > 1){
+				st.prev[x] = st.hist[0][x];
+			}
+			st.hist[0][x] = st.hist[1][x];
+			st.hist[1][x] = st.hist[2][x];
+			st.hist[2][x] = st.hist[3][x];
+			st.hist[3][x] = st.hist[4][x];
+			st.hist[4][x] = y;
+
+			//多记一个，弹出后仍然知道是否有5个跳变
+			if (st.nseen[x] < 6){
+				st.nseen[x] += 1;
+			}
+		}
+	}
+
+	return;
+}
+
+/*Move the matches that can no longer be cancelled from band->hits to
+   band->lines.
+  Matches are produced in row order, so they are bucketed by column to give
+   the band exactly the column-major order of the strided scan.
+  A match stays pending while a transition closer than min_run_px below
+   its last row can still cancel it; unless the image ends at row y
+   (final), pending matches are kept in band->hits for the next strip.*/
+void QRLocator::_settleColumnHits(QRScanBand *band, int width, int y, int final)
+{
+	QRColumnState st;
+	QRFinderLine *hit;
+	QRFinderLine *hits;
+	QRFinderLine *lines;
+	int start;
+	int count;
+	int nkeep;
+	int i;
+	int x;
+
+	_columnState((int *)m_ColStateBuf.data, width, &st);
+	for (x = band->start; x < band->end; ++x){
+		if (st.pending[x] >= 0){
+			if (!final && y - st.hist[4][x] < m_Config.min_run_px){
+				st.nhits[x] -= 1;
+			} else {
+				st.pending[x] = -1;
+			}
+		}
+	}
+
+	//按列分桶，同一列内保持行的顺序
+	start = 0;
+	for (x = band->start; x < band->end; ++x){
+		count = st.nhits[x];
+		st.nhits[x] = start;
+		start += count;
+	}
+
+	lines = _growLines(band->lines, 0, start);
+	hits = (QRFinderLine *)band->hits.data;
+	nkeep = 0;
+	for (i = 0; i < band->nhits; ++i){
+		hit = hits + i;
+		if (0 == hit->len){
+			continue;
+		}
+		x = QR_TO_ACTUAL(hit->pos[0]);
+		if (st.pending[x] == i){
+			st.pending[x] = nkeep;
+			hits[nkeep++] = *hit;
+		} else {
+			lines[st.nhits[x]++] = *hit;
+		}
+	}
+	band->nlines = start;
+	band->nhits = nkeep;
+
+	//留下的匹配重新计数
+	for (x = band->start; x < band->end; ++x){
+		st.nhits[x] = (st.pending[x] >= 0) ? 1 : 0;
+	}
+
+	return;
+}
+
+void QRLocator::_scanColumnsRowMajor(QRScanBand *band, const QRBinaryImage *img)
+{
+	_resetColumns(band, img->width);
+	_scanColumnRows(band, img, 0, 1, img->height);
+	_settleColumnHits(band, img->width, img->height, 1);
+
+	return;
+}
+
+/*Build one scan window per horizontal cluster.
+  Vertical lines that can cross the cluster lie in the columns of its center
+   section; the window widens that band by one center width on each side and
+   extends two finder widths above and below the rows of the cluster, so
+   every vertical run window through the finder has all of its transitions
+   strictly inside.*/
+int QRLocator::_buildScanWindows(int width, int height)
+{
+	QRFinderCluster *c;
+	QRFinderLine *l;
+	QRScanWindow *win;
+	QRScanWindow tmp;
+	int nwin;
+	int margin;
+	int i;
+	int j;
+
+	m_Windows = (QRScanWindow *)_growBuffer(m_WindowBuf, 0, MAX(1, m_nXClusters) * sizeof(QRScanWindow));
+	nwin = 0;
+	for (i = 0; i < m_nXClusters; ++i){
+		c = m_XClusters + i;
+		win = m_Windows + nwin;
+		win->x0 = 0x7FFFFFFF;
+		win->x1 = 0;
+		win->y0 = 0x7FFFFFFF;
+		win->y1 = 0;
+		margin = 0;
+		for (j = 0; j < c->nlines; ++j){
+			l = c->lines + j;
+			win->x0 = MIN(win->x0, l->pos[0] - l->len);
+			win->x1 = MAX(win->x1, l->pos[0] + 2 * l->len);
+			win->y0 = MIN(win->y0, l->pos[1]);
+			win->y1 = MAX(win->y1, l->pos[1]);
+			margin = MAX(margin, l->boffs + l->len + l->eoffs);
+		}
+
+		//finder宽度约为(boffs + len + eoffs)的7/6，上下各留两个finder
+		margin = margin * 7 / 3;
+		win->x0 = MAX(0, QR_TO_ACTUAL(win->x0));
+		win->x1 = MIN(width, QR_TO_ACTUAL(win->x1) + 1);
+		win->y0 = MAX(0, QR_TO_ACTUAL(win->y0 - margin));
+		win->y1 = MIN(height, QR_TO_ACTUAL(win->y1 + margin) + 1);
+
+		//按x0插入排序
+		for (j = nwin; j > 0 && m_Windows[j - 1].x0 > m_Windows[j].x0; --j){
+			tmp = m_Windows[j - 1];
+			m_Windows[j - 1] = m_Windows[j];
+			m_Windows[j] = tmp;
+		}
+		nwin += 1;
+	}
+
+	return nwin;
+}
+
+/*Vertical pass restricted to the scan windows of the horizontal clusters.
+  Columns are still visited left to right and the windows covering a column
+   are merged and scanned top to bottom, so the band keeps the column-major
+   order of the full scan.*/
+void QRLocator::_scanColumnsTargeted(QRScanBand *band, const QRBinaryImage *img, int nwin)
+{
+	int (*span)[2];
+	int *edges;
+	int nspan;
+	int next;
+	int nedges;
+	int tmp;
+	int x;
+	int i;
+	int j;
+	int k;
+
+	//定向扫描不用hits，借来存放窗口的纵向范围
+	edges = (int *)band->edges.data;
+	span = (int (*)[2])_growBuffer(band->hits, 0, MAX(1, nwin) * 2 * sizeof(int));
+	x = band->start;
+	while (x < band->end){
+		//找出覆盖这一列的窗口，按y0排序后合并
+		nspan = 0;
+		next = band->end;
+		for (i = 0; i < nwin && m_Windows[i].x0 <= x; ++i){
+			if (m_Windows[i].x1 <= x){
+				continue;
+			}
+			span[nspan][0] = m_Windows[i].y0;
+			span[nspan][1] = m_Windows[i].y1;
+			for (j = nspan; j > 0 && span[j - 1][0] > span[j][0]; --j){
+				tmp = span[j - 1][0]; span[j - 1][0] = span[j][0]; span[j][0] = tmp;
+				tmp = span[j - 1][1]; span[j - 1][1] = span[j][1]; span[j][1] = tmp;
+			}
+			nspan += 1;
+		}
+
+		if (0 == nspan){
+			//跳到下一个窗口
+			if (i < nwin){
+				next = m_Windows[i].x0;
+			}
+			x = next;
+			continue;
+		}
+
+		for (i = 0; i < nspan; i = j){
+			for (j = i + 1; j < nspan && span[j][0] <= span[i][1]; ++j){
+				span[i][1] = MAX(span[i][1], span[j][1]);
+			}
+
+			nedges = _columnTransitions(img, x, span[i][0], span[i][1] - span[i][0], edges);
+			for (k = 0; k < nedges; ++k){
+				edges[k] += span[i][0];
+			}
+			if (nedges > 0){
+				_scanRuns(band, edges, nedges, _isBlack(img, x, edges[0]), x, 1);
+			}
+			band->scannedPixels += span[i][1] - span[i][0];
+		}
+
+		x += 1;
+	}
+
+	return;
+}
+
+//扫描一行，返回新找到的finder line个数
+int QRLocator::_scanRow(QRScanBand *band, const QRBinaryImage *img, int y)
+{
+	int *edges;
+	int nedges;
+	int nlines;
+
+	edges = (int *)band->edges.data;
+	nlines = band->nlines;
+	nedges = _rowTransitions(img, y, edges);
+	if (nedges > 0){
+		_scanRuns(band, edges, nedges, _isBlack(img, edges[0], y), y, 0);
+	}
+	band->scannedRows += 1;
+
+	return band->nlines - nlines;
+}
+
+//执行一个带上的扫描或二值化任务
+void QRLocator::_scanBand(QRScanBand *band)
+{
+	const QRBinaryImage *img;
+	QRClusterBuilder *feed;
+	Mat rows;
+	int step;
+	int y;
+
+	img = m_Job.img;
+	switch (m_Job.type){
+		case QR_SCANJOB_SHRINK:
+			//整数倍缩小，每个输出行只用到原图对应的2^levels行
+			rows = m_Job.dst->rowRange(band->start, band->end);
+			resize(m_Job.src->rowRange(band->start << m_Job.levels, band->end << m_Job.levels), rows, rows.size(),
+			       0, 0, INTER_AREA);
+			break;
+		case QR_SCANJOB_GRAY:
+			QR_GrayRows(m_Job.src->ptr(band->start), (int)m_Job.src->step, m_Job.src->channels(), m_Job.src->cols,
+			            band->end - band->start, m_Job.dst->ptr(band->start), (int)m_Job.dst->step);
+			break;
+		case QR_SCANJOB_THRESHOLD:
+			QR_ThresholdBitRows(m_Job.dst->data, (int)m_Job.dst->step, m_Job.dst->cols, m_Job.dst->rows,
+			                    band->start, band->end, m_Job.bits, m_Job.words,
+			                    QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA, (int *)band->edges.data);
+			break;
+		case QR_SCANJOB_DILATE:
+			QR_DilateBitRows(m_Job.bits, m_Job.tmp, m_Job.dst->cols, m_Job.dst->rows, m_Job.words, band->start, band->end);
+			break;
+		case QR_SCANJOB_ERODE:
+			QR_ErodeBitRows(m_Job.tmp, m_Job.bits, m_Job.dst->cols, m_Job.dst->rows, m_Job.words, band->start, band->end);
+			break;
+		case QR_SCANJOB_ROWS:
+			for (y = band->start; y < band->end; ++y){
+				_scanRow(band, img, y);
+			}
+			break;
+		case QR_SCANJOB_PROBE:
+			//只是试探，结果在第二遍按顺序重新生成
+			step = m_Job.step;
+			feed = band->feed;
+			band->feed = NULL;
+			for (y = (band->start + step - 1) / step * step; y < band->end; y += step){
+				if (_scanRow(band, img, y) > 0){
+					m_Job.mark[y] = 1;
+				}
+				band->nlines = 0;
+			}
+			band->feed = feed;
+			break;
+		case QR_SCANJOB_MARKED:
+			for (y = band->start; y < band->end; ++y){
+				if (0 != m_Job.mark[y]){
+					_scanRow(band, img, y);
+				}
+			}
+			break;
+		case QR_SCANJOB_STRIDED:
+			_scanColumnsStrided(band, img);
+			break;
+		case QR_SCANJOB_TRANSPOSED:
+			_scanColumnsTransposed(band, m_Job.trans, img->height);
+			break;
+		case QR_SCANJOB_TARGETED:
+			_scanColumnsTargeted(band, img, m_Job.nwin);
+			break;
+		default:
+			_scanColumnsRowMajor(band, img);
+			break;
+	}
+
+	return;
+}
+
+void QRLocator::_runBand(void *arg, int index, int worker)
+{
+	QRLocator *locator;
+
+	locator = (QRLocator *)arg;
+	locator->_scanBand(locator->m_Bands + index);
+}
+
+/*Split [0, n) into the bands of one pass.
+  Band boundaries are multiples of align; a single band is used when
+   scanning on one thread, and its lines then go straight to feed.
+  Return: The number of bands.*/
+int QRLocator::_splitBands(int n, int align, int maxEdges, QRClusterBuilder *feed)
+{
+	QRScanBand *band;
+	int nbands;
+	int size;
+	int i;
+
+	nbands = 1;
+	if (NULL != m_Pool){
+		nbands = MIN(QR_ThreadPoolSize(m_Pool) * QR_CONFIG_BANDS_PER_THREAD, QR_CONFIG_MAX_SCAN_BANDS);
+		nbands = MAX(1, MIN(nbands, n / QR_CONFIG_MIN_BAND_SIZE));
+	}
+
+	size = (n + nbands - 1) / nbands;
+	size = (size + align - 1) / align * align;
+	nbands = MAX(1, (n + size - 1) / size);
+	for (i = 0; i < nbands; ++i){
+		band = m_Bands + i;
+		band->start = i * size;
+		band->end = MIN(n, band->start + size);
+		band->nlines = 0;
+		band->feed = (1 == nbands) ? feed : NULL;
+		band->nhits = 0;
+		band->scannedRows = 0;
+		band->scannedPixels = 0;
+		_reserveMat(band->edges, 1, maxEdges, CV_32SC1);
+	}
+
+	return nbands;
+}
+
+//配置的线程数变化时重建线程池
+void QRLocator::_preparePool(void)
+{
+	if (!m_OwnPool || QR_ThreadPoolSize(m_Pool) == MAX(1, m_Config.threads)){
+		return;
+	}
+
+	QR_DestroyThreadPool(m_Pool);
+	m_Pool = NULL;
+	if (m_Config.threads > 1){
+		m_Pool = QR_CreateThreadPool(m_Config.threads);
+	}
+
+	return;
+}
+
+/*Find the finder lines of a binary image.
+  Both passes are split into bands of rows or columns that run on the
+   thread pool; the lines of the bands are joined in order, so the result is
+   exactly that of a single band covering the whole image.
+  minModule is min_module_px at the scale of img. Above 1 the horizontal
+   pass only samples every step-th row first. The center of a finder is 3
+   modules tall, so with modules of at least minModule pixels a step of
+   3*minModule-2 rows cannot jump over it. Every sampled row that finds a
+   line marks the step-1 rows on each side; the marked rows are then
+   scanned in order, which fills in the whole center band and keeps the
+   lines in row order for the clustering.
+  The lines are clustered as they arrive, so a frame may hold any number of
+   them.*/
+void QRLocator::_scanImage(const QRBinaryImage *img, int minModule)
+{
+	unsigned char *probe;
+	unsigned char *mark;
+	int nbands;
+	int width;
+	int height;
+	int step;
+	int y;
+	int k;
+
+	width = img->width;
+	height = img->height;
+	m_nScannedRows = 0;
+	m_nScannedPixels = 0;
+	_preparePool();
+	m_Job.img = img;
+
+	_clusterBegin(&m_XBuilder, 0);
+	nbands = _splitBands(height, 1, MAX(width, height), &m_XBuilder);
+	if (minModule > 1){
+		step = MAX(1, 3 * minModule - 2);
+		probe = _reserveMat(m_RowMarkBuf, 2, height, CV_8UC1).data;
+		mark = probe + height;
+		memset(probe, 0, 2 * height);
+
+		m_Job.type = QR_SCANJOB_PROBE;
+		m_Job.step = step;
+		m_Job.mark = probe;
+		QR_RunTasks(m_Pool, _runBand, this, nbands);
+
+		for (y = 0; y < height; y += step){
+			if (0 != probe[y]){
+				for (k = MAX(0, y - step + 1); k < MIN(height, y + step); ++k){
+					mark[k] = 1;
+				}
+			}
+		}
+
+		m_Job.type = QR_SCANJOB_MARKED;
+		m_Job.mark = mark;
+	} else {
+		m_Job.type = QR_SCANJOB_ROWS;
+	}
+	QR_RunTasks(m_Pool, _runBand, this, nbands);
+	_joinBands(nbands, &m_XBuilder);
+
+	//行方向先分组，定向扫描列时需要用到
+	m_nXClusters = _clusterEnd(&m_XBuilder, &m_XLines, &m_XLineSize, &m_XClusters);
+
+	switch (m_Config.vscan){
+		case QR_VSCAN_STRIDED:
+			m_Job.type = QR_SCANJOB_STRIDED;
+			break;
+		case QR_VSCAN_TRANSPOSE:
+			m_Job.type = QR_SCANJOB_TRANSPOSED;
+			m_Job.trans = _transposeImage(img);
+			break;
+		case QR_VSCAN_TARGETED:
+			m_Job.type = QR_SCANJOB_TARGETED;
+			m_Job.nwin = _buildScanWindows(width, height);
+			break;
+		default:
+			m_Job.type = QR_SCANJOB_ROWMAJOR;
+			_reserveMat(m_ColStateBuf, 9, width + 1, CV_32SC1);
+			break;
+	}
+
+	//位图按64列对齐，各带不会共用一个字
+	_clusterBegin(&m_YBuilder, 1);
+	nbands = _splitBands(width, (NULL != img->bits) ? 64 : 1, MAX(width, height), &m_YBuilder);
+	QR_RunTasks(m_Pool, _runBand, this, nbands);
+	_joinBands(nbands, &m_YBuilder);
+	m_nYClusters = _clusterEnd(&m_YBuilder, &m_YLines, &m_YLineSize, &m_YClusters);
+
+	if (QR_SCANJOB_TARGETED != m_Job.type){
+		m_nScannedPixels = width * height;
+	}
+	
+	return;
+}
+
+/*Determine if a horizontal line crosses a vertical line.
+  _hline: The horizontal line.
+  _vline: The vertical line.
+  Return: A non-zero value if the lines cross, or zero if they do not.*/
+static int _linesAreCrossing(const QRFinderLine *_hline,
+ const QRFinderLine *_vline){
+  return
+   _hline->pos[0]<=_vline->pos[0]&&_vline->pos[0]<_hline->pos[0]+_hline->len&&
+   _vline->pos[1]<=_hline->pos[1]&&_hline->pos[1]<_vline->pos[1]+_vline->len;
+}
+
+static void _calcMiddleLine(QRFinderCluster** clusters, int nCluster, int _v, QRFinderLine* line)
+{
+	QRFinderCluster* c;
+	int i;
+	int j;
+	int len;
+	int start;
+	int count;
+	int min;
+	int max;
+
+	start = 0;
+	len = 0;
+	count = 0;
+	min = 0x7FFFFFFF;
+	max = 0;
+	for (i = 0; i < nCluster; ++i){
+		c = clusters[i];
+		for (j = 0; j < c->nlines; ++j){
+			start += c->lines[j].pos[_v];
+			len += c->lines[j].len;
+			count += 1;
+
+			if (c->lines[j].pos[1-_v] > max){
+				max = c->lines[j].pos[1-_v];
+			}
+
+			if (c->lines[j].pos[1-_v] < min){
+				min = c->lines[j].pos[1-_v];
+			}
+		}
+	}
+
+	line->pos[_v] = (start + (count >> 2))/count;
+	line->pos[1-_v] = (min + max + 1)/2;
+	line->len = (len + (count >> 2))/count;
+	line->boffs = 0;
+	line->eoffs = 0;
+	
+	return;
+}
+
+//按坐标排序的cluster中间线
+typedef struct QRCrossKey{
+	int key;
+	int index;
+} QRCrossKey;
+
+static int _compareKeys(const void *a, const void *b)
+{
+	const QRCrossKey *ka;
+	const QRCrossKey *kb;
+
+	ka = (const QRCrossKey *)a;
+	kb = (const QRCrossKey *)b;
+	if (ka->key != kb->key){
+		return (ka->key < kb->key) ? -1 : 1;
+	}
+
+	return ka->index - kb->index;
+}
+
+//cluster中间的一条线
+static const QRFinderLine* _medianLine(const QRFinderCluster *c)
+{
+	return c->lines + (c->nlines>>1);
+}
+
+//中间线按pos[_v]排序
+static void _sortMedians(const QRFinderCluster *clusters, int n, int _v, QRCrossKey *keys)
+{
+	int i;
+
+	for (i = 0; i < n; ++i){
+		keys[i].key = _medianLine(clusters + i)->pos[_v];
+		keys[i].index = i;
+	}
+	qsort(keys, n, sizeof(QRCrossKey), _compareKeys);
+
+	return;
+}
+
+//第一个不小于value的key
+static int _lowerBound(const QRCrossKey *keys, int n, int value)
+{
+	int lo;
+	int hi;
+	int mid;
+
+	lo = 0;
+	hi = n;
+	while (lo < hi){
+		mid = (lo + hi) >> 1;
+		if (keys[mid].key < value){
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/*Find the centers where the clusters of both directions cross.
+  For each X cluster not yet taken, in order, the Y clusters whose median
+   line crosses its median line give the vertical middle line; the X
+   clusters after it whose median line crosses that middle line are taken
+   and give the horizontal one.
+  The Y medians are sorted by x and the X medians by y, so each step only
+   tests the lines whose position already falls inside the line it is
+   crossed with, instead of every cluster. A Y cluster may still serve
+   several centers.
+  Centers past the first centerSize are counted in dropped.
+  Return: The number of centers stored, at most centerSize.*/
+static int _findCrossing(QRFinderCenter *centers, int centerSize, int *dropped,
+						  QRFinderCluster* xClusters, int nxCluster, 
+						  QRFinderCluster* yClusters, int nyCluster,
+						  QRFinderCluster** xNeighbors,
+						  QRFinderCluster** yNeighbors,
+						  QRCrossKey *xKeys, QRCrossKey *yKeys,
+						  char *xMark)
+{
+	int i;
+	int j;
+	int k;
+	const QRFinderLine *a;
+	const QRFinderLine *b;
+	QRFinderLine xMiddleLine;
+	QRFinderLine yMiddleLine;
+	int nxNeighbors;	
+	int nyNeighbors;
+	int nCenters;
+
+	_sortMedians(xClusters, nxCluster, 1, xKeys);
+	_sortMedians(yClusters, nyCluster, 0, yKeys);
+	memset(xMark, 0, nxCluster);
+	nCenters = 0;
+	
+	for (i = 0; i < nxCluster; ++i){
+		if (1 == xMark[i]){
+			continue;
+		}
+
+		//只有x落在a上的竖线可能和它交叉
+		nyNeighbors = 0;
+		a = _medianLine(xClusters + i);
+		for (k = _lowerBound(yKeys, nyCluster, a->pos[0]); k < nyCluster && yKeys[k].key < a->pos[0] + a->len; ++k){
+			j = yKeys[k].index;
+			b = _medianLine(yClusters + j);
+			if (_linesAreCrossing(a, b)){
+				yNeighbors[nyNeighbors++] = yClusters + j;
+			}
+		}
+
+		if (nyNeighbors > 0){
+			_calcMiddleLine(yNeighbors, nyNeighbors, 1, &yMiddleLine);
+			nxNeighbors = 0;
+			xNeighbors[nxNeighbors++] = xClusters+i;
+			
+			//y落在竖直中线上的横线
+			for (k = _lowerBound(xKeys, nxCluster, yMiddleLine.pos[1]); k < nxCluster && xKeys[k].key < yMiddleLine.pos[1] + yMiddleLine.len; ++k){
+				j = xKeys[k].index;
+				if (j <= i){
+					continue;
+				}
+
+				a = _medianLine(xClusters + j);
+				if (_linesAreCrossing(a, &yMiddleLine)){
+					xMark[j]=1;
+					xNeighbors[nxNeighbors++] = xClusters + j;
+				}
+			}
+
+			_calcMiddleLine(xNeighbors, nxNeighbors, 0, &xMiddleLine);
+
+			if (nCenters < centerSize){
+				centers[nCenters].pos[0] = yMiddleLine.pos[0];
+				centers[nCenters].pos[1] = xMiddleLine.pos[1];
+				centers[nCenters].len = (yMiddleLine.len + xMiddleLine.len) / 2;
+				nCenters += 1;
+			} else {
+				*dropped += 1;
+			}
+		}
+	}
+
+	return nCenters;
+}
+
+static void _drawXFinderLine(Mat &img, QRFinderLine *line)
+{
+	cv::line(img, 
+			 Point(QR_TO_ACTUAL(line->pos[0] - line->boffs), QR_TO_ACTUAL(line->pos[1])), 
+			 Point(QR_TO_ACTUAL(line->pos[0] + line->len + line->eoffs), QR_TO_ACTUAL(line->pos[1])), 
+			 g_Green);
+
+	return;
+}
+
+static void _drawYFinderLine(Mat &img, QRFinderLine *line)
+{
+	cv::line(img, 
+			Point(QR_TO_ACTUAL(line->pos[0]), QR_TO_ACTUAL(line->pos[1] - line->boffs)), 
+			Point(QR_TO_ACTUAL(line->pos[0]), QR_TO_ACTUAL(line->pos[1] + line->len + line->eoffs)),
+			g_Green);
+
+	return;
+}
+
+//画出finder line
+static void _drawFinderLines(Mat &img, QRFinderLine* lines, int lsize, int _v)
+{
+	int i;
+
+	printf("find [%d] lines.\r\n", lsize);
+
+	for (i = 0; i < lsize; ++i){
+		if (0 == _v){
+			_drawXFinderLine(img, lines + i);
+		} else {
+			_drawYFinderLine(img, lines + i);
+		}
+	}
+
+	return;
+}
+
+//画出cluster
+static void _drawCluster(Mat &img, QRFinderCluster *cluster, int clusterSize, int _v)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < clusterSize; ++i){
+		for (j = 0; j < cluster->nlines; ++j){
+			if (0 == _v){
+				_drawXFinderLine(img, cluster->lines + j);
+			} else {
+				_drawYFinderLine(img, cluster->lines + j);
+			}
+		}
+		cluster += 1;
+	}
+
+	return;
+}
+
+static void _drawCenters(Mat &img, QRFinderCenter *centers, int nCenters)
+{
+	int i;
+
+	for (i = 0; i < nCenters; ++i){
+
+		cv::line(img, 
+				 Point(QR_TO_ACTUAL(centers[i].pos[0]) - 3, QR_TO_ACTUAL(centers[i].pos[1])), 
+				 Point(QR_TO_ACTUAL(centers[i].pos[0]) + 3, QR_TO_ACTUAL(centers[i].pos[1])),
+				 g_Red);
+
+		cv::line(img, 
+				 Point(QR_TO_ACTUAL(centers[i].pos[0]), QR_TO_ACTUAL(centers[i].pos[1]) - 3), 
+				 Point(QR_TO_ACTUAL(centers[i].pos[0]), QR_TO_ACTUAL(centers[i].pos[1]) + 3),
+				 g_Red);		
+	}
+
+	return;
+}
+
+//过滤finder line
+void QRLocator::_findCenters(void)
+{	
+	QRFinderCluster **neighbors;
+	QRCrossKey *keys;
+	char *mark;
+	int limit;
+	int n;
+
+	//两个方向的分组在扫描时已经完成
+	n = m_nXClusters + m_nYClusters;
+	neighbors = (QRFinderCluster **)_growBuffer(m_CrossBuf, 0, MAX(1, n) * (sizeof(QRFinderCluster *) + sizeof(QRCrossKey) + 1));
+	keys = (QRCrossKey *)(neighbors + n);
+	mark = (char *)(keys + n);
+
+	//每个x方向的cluster最多给出一个center
+	limit = m_nXClusters;
+	if (m_Config.max_centers > 0){
+		limit = MIN(limit, m_Config.max_centers);
+	}
+	m_Centers = (QRFinderCenter *)_growBuffer(m_CenterBuf, 0, MAX(1, limit) * sizeof(QRFinderCenter));
+	
+	//判断cluster是否交叉
+	m_nCenters = _findCrossing(m_Centers, limit, &m_nDroppedCenters,
+    						  m_XClusters, m_nXClusters,
+    						  m_YClusters, m_nYClusters,
+    						  neighbors, neighbors + m_nXClusters,
+    						  keys, keys + m_nXClusters,
+    						  mark);
+
+	return;
+}
+
+//center的空间索引，格子按行排列，每个格子中的center在order中连续存放
+typedef struct QRCenterGrid{
+	int  x0;
+	int  y0;
+	int  cell;   //格子的边长，精确坐标
+	int  cols;
+	int  rows;
+	int *start;  //每个格子在order中的起点，共cols*rows+1个
+	int *order;
+} QRCenterGrid;
+
+//三个一组的候选
+typedef struct QRTriple{
+	int    inside;    //落在二维码范围内的其他center数
+	double score;
+	int    center[3];
+} QRTriple;
+
+static int _cellOf(const QRCenterGrid *grid, const QRFinderCenter *c)
+{
+	return (c->pos[1] - grid->y0) / grid->cell * grid->cols + (c->pos[0] - grid->x0) / grid->cell;
+}
+
+/*Sort the centers into a grid of square cells.
+  The cells start at about 8 center widths, the size of a small code, and
+   are doubled until there are at most about 4 per center, so a few centers
+   scattered over a large frame do not need a large grid.
+  start must hold 4 * n + 5 ints and order n ints.*/
+static void _buildCenterGrid(const QRFinderCenter *centers, int n, QRCenterGrid *grid)
+{
+	int minx;
+	int miny;
+	int maxx;
+	int maxy;
+	int len;
+	int i;
+	int k;
+
+	minx = 0x7FFFFFFF;
+	miny = 0x7FFFFFFF;
+	maxx = 0;
+	maxy = 0;
+	len = 0;
+	for (i = 0; i < n; ++i){
+		minx = MIN(minx, centers[i].pos[0]);
+		miny = MIN(miny, centers[i].pos[1]);
+		maxx = MAX(maxx, centers[i].pos[0]);
+		maxy = MAX(maxy, centers[i].pos[1]);
+		len += centers[i].len;
+	}
+
+	grid->x0 = minx;
+	grid->y0 = miny;
+	grid->cell = MAX(1, len / n * 8);
+	for (;;){
+		grid->cols = (maxx - minx) / grid->cell + 1;
+		grid->rows = (maxy - miny) / grid->cell + 1;
+		if ((int64_t)grid->cols * grid->rows <= 4 * n + 4){
+			break;
+		}
+		grid->cell *= 2;
+	}
+
+	//按格子计数排序，start先记下每个格子的终点
+	memset(grid->start, 0, sizeof(int) * (grid->cols * grid->rows + 1));
+	for (i = 0; i < n; ++i){
+		grid->start[_cellOf(grid, centers + i) + 1] += 1;
+	}
+	for (k = 0; k < grid->cols * grid->rows; ++k){
+		grid->start[k + 1] += grid->start[k];
+	}
+	for (i = n - 1; i >= 0; --i){
+		k = _cellOf(grid, centers + i) + 1;
+		grid->start[k] -= 1;
+		grid->order[grid->start[k]] = i;
+	}
+	for (k = 0; k < grid->cols * grid->rows; ++k){
+		grid->start[k] = grid->start[k + 1];
+	}
+	grid->start[grid->cols * grid->rows] = n;
+
+	return;
+}
+
+static int64_t _centerDist(const QRFinderCenter *a, const QRFinderCenter *b)
+{
+	int64_t dx;
+	int64_t dy;
+
+	dx = b->pos[0] - a->pos[0];
+	dy = b->pos[1] - a->pos[1];
+
+	return dx * dx + dy * dy;
+}
+
+/*Find the k centers nearest to center i, no farther than radius.
+  The cells are visited ring by ring around the cell of i; the search stops
+   once a ring lies beyond the radius, or beyond the k-th center when k
+   have been found.
+  Return: The number of centers stored in out, nearest first.*/
+static int _nearestCenters(const QRFinderCenter *centers, const QRCenterGrid *grid, int i,
+                           int64_t radius, int *out, int k)
+{
+	int64_t dist[QR_CONFIG_GROUP_NEIGHBORS];
+	int64_t reach;
+	int64_t d;
+	int cx;
+	int cy;
+	int x;
+	int y;
+	int r;
+	int m;
+	int j;
+	int p;
+	int nout;
+
+	cx = (centers[i].pos[0] - grid->x0) / grid->cell;
+	cy = (centers[i].pos[1] - grid->y0) / grid->cell;
+	nout = 0;
+	for (r = 0; r <= MAX(grid->cols, grid->rows); ++r){
+		//第r圈中的center至少相距r-1个格子
+		reach = (int64_t)MAX(0, r - 1) * grid->cell;
+		if (reach > radius || (nout == k && reach * reach > dist[k - 1])){
+			break;
+		}
+
+		for (y = MAX(0, cy - r); y <= MIN(grid->rows - 1, cy + r); ++y){
+			for (x = MAX(0, cx - r); x <= MIN(grid->cols - 1, cx + r); ++x){
+				//圈内部的格子已经访问过
+				if (y != cy - r && y != cy + r && x != cx - r && x != cx + r){
+					continue;
+				}
+
+				for (m = grid->start[y * grid->cols + x]; m < grid->start[y * grid->cols + x + 1]; ++m){
+					j = grid->order[m];
+					d = _centerDist(centers + i, centers + j);
+					if (j == i || d > radius * radius){
+						continue;
+					}
+
+					//按距离插入，距离相同时下标小的在前
+					p = (nout < k) ? nout++ : k;
+					while (p > 0 && (dist[p - 1] > d || (dist[p - 1] == d && out[p - 1] > j))){
+						if (p < k){
+							dist[p] = dist[p - 1];
+							out[p] = out[p - 1];
+						}
+						p -= 1;
+					}
+					if (p < k){
+						dist[p] = d;
+						out[p] = j;
+					}
+				}
+			}
+		}
+	}
+
+	return nout;
+}
+
+/*The module width of a code with finder centers a, b and c, and its top
+   edge along (dx, dy).
+  Centers are measured along the x and y axes, which cross a rotated finder
+   on a longer path, by up to sqrt(2) at 45 degrees.*/
+static double _moduleWidth(const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c, double dx, double dy)
+{
+	//中心黑块宽3个模块
+	return (a->len + b->len + c->len) / 9.0 * MAX(fabs(dx), fabs(dy)) / sqrt(dx * dx + dy * dy);
+}
+
+/*Score three centers as the finders of one code with its corner at a.
+  The arms from a to b and c must be about as long and about square to each
+   other, the centers about as wide, and the arms 14 to 170 modules long
+   (versions 1 to 40) for the module width the centers give.
+  Return: The score, lower fits better, or -1 if they cannot form a code.*/
+static double _scoreTriple(const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c)
+{
+	double tol;
+	double ux;
+	double uy;
+	double vx;
+	double vy;
+	double lu;
+	double lv;
+	double cosine;
+	double arms;
+	double widths;
+	double module;
+	double spacing;
+
+	tol = QR_CONFIG_GROUP_TOLERANCE / 100.0;
+	ux = b->pos[0] - a->pos[0];
+	uy = b->pos[1] - a->pos[1];
+	vx = c->pos[0] - a->pos[0];
+	vy = c->pos[1] - a->pos[1];
+	lu = sqrt(ux * ux + uy * uy);
+	lv = sqrt(vx * vx + vy * vy);
+	if (0 == lu || 0 == lv){
+		return -1;
+	}
+
+	cosine = fabs(ux * vx + uy * vy) / (lu * lv);
+	arms = MAX(lu, lv) / MIN(lu, lv) - 1;
+	widths = (double)MAX(a->len, MAX(b->len, c->len)) / MAX(1, MIN(a->len, MIN(b->len, c->len))) - 1;
+	if (cosine > tol || arms > tol || widths > 2 * tol){
+		return -1;
+	}
+
+	module = _moduleWidth(a, b, c, ux, uy);
+	spacing = (lu + lv) / 2 / module;
+	if (spacing < 14 * (1 - tol) || spacing > 170 * (1 + tol)){
+		return -1;
+	}
+
+	return cosine + arms + widths / 2;
+}
+
+/*Count the other centers inside the parallelogram spanned by a triple,
+   widened by 3 modules on every side.
+  Codes do not overlap, so three finders taken from neighbouring codes of a
+   regular sheet, which can lie just as square as those of one code, have
+   the finders of the codes between them inside or on their edges. The
+   finders of the next code are at least 7 modules away from a real one.*/
+static int _countInside(const QRFinderCenter *centers, const QRCenterGrid *grid, const QRTriple *t)
+{
+	const QRFinderCenter *a;
+	const QRFinderCenter *p;
+	double ux;
+	double uy;
+	double vx;
+	double vy;
+	double det;
+	double margin;
+	double ms;
+	double mr;
+	double s;
+	double r;
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	int x;
+	int y;
+	int m;
+	int j;
+	int count;
+
+	a = centers + t->center[0];
+	ux = centers[t->center[1]].pos[0] - a->pos[0];
+	uy = centers[t->center[1]].pos[1] - a->pos[1];
+	vx = centers[t->center[2]].pos[0] - a->pos[0];
+	vy = centers[t->center[2]].pos[1] - a->pos[1];
+	det = ux * vy - uy * vx;
+	if (0 == det){
+		return 0;
+	}
+
+	//扩张的宽度换算成两条边上的比例
+	margin = _moduleWidth(a, centers + t->center[1], centers + t->center[2], ux, uy) * 3;
+	ms = margin / sqrt(ux * ux + uy * uy);
+	mr = margin / sqrt(vx * vx + vy * vy);
+
+	//扩张后的外框覆盖的格子
+	x0 = (int)(a->pos[0] + MIN(0.0, ux) + MIN(0.0, vx) - 2 * margin - grid->x0) / grid->cell;
+	x1 = (int)(a->pos[0] + MAX(0.0, ux) + MAX(0.0, vx) + 2 * margin - grid->x0) / grid->cell;
+	y0 = (int)(a->pos[1] + MIN(0.0, uy) + MIN(0.0, vy) - 2 * margin - grid->y0) / grid->cell;
+	y1 = (int)(a->pos[1] + MAX(0.0, uy) + MAX(0.0, vy) + 2 * margin - grid->y0) / grid->cell;
+
+	count = 0;
+	for (y = MAX(0, y0); y <= MIN(grid->rows - 1, y1); ++y){
+		for (x = MAX(0, x0); x <= MIN(grid->cols - 1, x1); ++x){
+			for (m = grid->start[y * grid->cols + x]; m < grid->start[y * grid->cols + x + 1]; ++m){
+				j = grid->order[m];
+				if (j == t->center[0] || j == t->center[1] || j == t->center[2]){
+					continue;
+				}
+
+				//p - a = s * u + r * v
+				p = centers + j;
+				s = ((p->pos[0] - a->pos[0]) * vy - (p->pos[1] - a->pos[1]) * vx) / det;
+				r = (ux * (p->pos[1] - a->pos[1]) - uy * (p->pos[0] - a->pos[0])) / det;
+				if (s > -ms && s < 1 + ms && r > -mr && r < 1 + mr){
+					count += 1;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+/*The version a code with finder centers a, b and c is closest to.
+  The module width from the centers is only an estimate, so the arms are
+   snapped to the nearest 4 * version + 10 modules, the distance between the
+   finder centers of a version.*/
+static int _estimateVersion(const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c)
+{
+	double ux;
+	double uy;
+	double vx;
+	double vy;
+	int version;
+
+	ux = b->pos[0] - a->pos[0];
+	uy = b->pos[1] - a->pos[1];
+	vx = c->pos[0] - a->pos[0];
+	vy = c->pos[1] - a->pos[1];
+	version = (int)(((sqrt(ux * ux + uy * uy) + sqrt(vx * vx + vy * vy)) / 2 / _moduleWidth(a, b, c, ux, uy) - 10) / 4 + 0.5);
+
+	return MAX(1, MIN(40, version));
+}
+
+/*The colour of the binary frame, scaled down by shift, at the subpel point
+   (x, y), where the pixel x covers x - 0.5 to x + 0.5.
+  Return: 1 for black, 0 for white, or -1 outside the frame.*/
+static int _sampleBlack(const QRBinaryImage *img, int shift, double x, double y)
+{
+	int ix;
+	int iy;
+
+	x += QR_TO_CALC(1) / 2;
+	y += QR_TO_CALC(1) / 2;
+	if (x < 0 || y < 0){
+		return -1;
+	}
+
+	ix = (int)x >> (QR_FINDER_SUBPREC + shift);
+	iy = (int)y >> (QR_FINDER_SUBPREC + shift);
+	if (ix >= img->width || iy >= img->height){
+		return -1;
+	}
+
+	return _isBlack(img, ix, iy);
+}
+
+/*The line along the timing pattern between center a and center e of a
+   code whose third finder is f, 3 + k / 3 modules from both centers toward
+   f. Each end is measured with the width of its own finder, as perspective
+   can make the modules at one end smaller than at the other.
+  line receives the start and the offset from there to the end.*/
+static void _timingLine(const QRFinderCenter *a, const QRFinderCenter *e, const QRFinderCenter *f, int k, double *line)
+{
+	double ux;
+	double uy;
+	double vx;
+	double vy;
+	double width;
+
+	ux = e->pos[0] - a->pos[0];
+	uy = e->pos[1] - a->pos[1];
+	vx = f->pos[0] - a->pos[0];
+	vy = f->pos[1] - a->pos[1];
+
+	//中心黑块宽3个模块，旋转后沿坐标轴量出的宽度要换算回去，见_moduleWidth
+	width = MAX(fabs(ux), fabs(uy)) / sqrt(ux * ux + uy * uy) / 3 / sqrt(vx * vx + vy * vy) * (3 + k / 3.0);
+	line[0] = a->pos[0] + vx * a->len * width;
+	line[1] = a->pos[1] + vy * a->len * width;
+	line[2] = e->pos[0] + vx * e->len * width - line[0];
+	line[3] = e->pos[1] + vy * e->len * width - line[1];
+}
+
+/*How well the timing pattern of a code with its corner finder at a shows
+   between a and b.
+  The arms are divided by the spacing of the version _estimateVersion picks.
+  The timing pattern runs 3 modules from the finder centers toward c, see
+   _timingLine, and changes colour at every module between the separators,
+   5 modules past either center. The line is followed pixel by pixel on the
+   binary frame, which is scaled down by shift, and the changes are counted.
+  Return: The share of the expected changes that were found, from 0 to 1.*/
+static double _timingFit(const QRBinaryImage *img, int shift,
+                         const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c)
+{
+	double line[4];
+	double lu;
+	double x;
+	double y;
+	double dx;
+	double dy;
+	int spacing;
+	int changes;
+	int best;
+	int steps;
+	int last;
+	int cur;
+	int i;
+	int k;
+
+	spacing = 4 * _estimateVersion(a, b, c) + 10;
+
+	//定位图形宽1个模块，位置有误差时偏移3个模块的线可能落在旁边，再试两侧各1/3个模块
+	best = 0;
+	for (k = -1; k <= 1; ++k){
+		_timingLine(a, b, c, k, line);
+		lu = sqrt(line[2] * line[2] + line[3] * line[3]);
+
+		//从第5个模块到倒数第5个模块，每个像素取一个点
+		steps = (int)(lu * (spacing - 10) / spacing / QR_TO_CALC(1 << shift));
+		x = line[0] + line[2] * 5 / spacing;
+		y = line[1] + line[3] * 5 / spacing;
+		dx = line[2] * QR_TO_CALC(1 << shift) / lu;
+		dy = line[3] * QR_TO_CALC(1 << shift) / lu;
+		last = -1;
+		changes = 0;
+		for (i = 0; i <= steps; ++i, x += dx, y += dy){
+			cur = _sampleBlack(img, shift, x, y);
+			if (cur < 0){
+				return 0;
+			}
+
+			if (last >= 0 && cur != last){
+				changes += 1;
+			}
+			last = cur;
+		}
+		best = MAX(best, changes);
+	}
+
+	return (best >= spacing - 10) ? 1 : (double)best / (spacing - 10);
+}
+
+//模块坐标(u, v)经过变换后的精确坐标
+static void _mapModule(const double *h, double u, double v, double *x, double *y)
+{
+	double w;
+
+	w = h[6] * u + h[7] * v + h[8];
+	*x = (h[0] * u + h[1] * v + h[2]) / w;
+	*y = (h[3] * u + h[4] * v + h[5]) / w;
+}
+
+/*Solve the perspective transform taking the four points src to dst, with
+   h[8] fixed at 1, by Gaussian elimination on the eight equations.
+  Return: 0 on success, or -1 if three of the points lie on one line.*/
+static int _solveTransform(const double src[4][2], const double dst[4][2], double *h)
+{
+	double m[8][9];
+	double f;
+	int pivot;
+	int i;
+	int j;
+	int k;
+
+	for (i = 0; i < 4; ++i){
+		//x * (h6 * u + h7 * v + 1) = h0 * u + h1 * v + h2，y同理
+		for (k = 0; k < 2; ++k){
+			memset(m[2 * i + k], 0, sizeof(m[0]));
+			m[2 * i + k][3 * k + 0] = src[i][0];
+			m[2 * i + k][3 * k + 1] = src[i][1];
+			m[2 * i + k][3 * k + 2] = 1;
+			m[2 * i + k][6] = -src[i][0] * dst[i][k];
+			m[2 * i + k][7] = -src[i][1] * dst[i][k];
+			m[2 * i + k][8] = dst[i][k];
+		}
+	}
+
+	for (i = 0; i < 8; ++i){
+		pivot = i;
+		for (j = i + 1; j < 8; ++j){
+			if (fabs(m[j][i]) > fabs(m[pivot][i])){
+				pivot = j;
+			}
+		}
+		if (fabs(m[pivot][i]) < 1e-9){
+			return -1;
+		}
+		for (k = i; k < 9; ++k){
+			f = m[i][k];
+			m[i][k] = m[pivot][k];
+			m[pivot][k] = f;
+		}
+
+		for (j = 0; j < 8; ++j){
+			if (j == i || 0 == m[j][i]){
+				continue;
+			}
+			f = m[j][i] / m[i][i];
+			for (k = i; k < 9; ++k){
+				m[j][k] -= f * m[i][k];
+			}
+		}
+	}
+
+	for (i = 0; i < 8; ++i){
+		h[i] = m[i][8] / m[i][i];
+	}
+	h[8] = 1;
+
+	return 0;
+}
+
+/*Read the version of a code from its timing patterns.
+  Row 6 of a code runs from the bottom ring of one finder over the
+   separator, the timing pattern and the other separator to the next finder,
+   so a line along it from center a to center b changes colour
+   4 * version + 4 times whatever the module width.
+  The line is the one _timingLine gives, tried 1/3 module to either side as
+   well, on both arms; the version most of the six lines agree on wins.
+  Return: The version, or the estimate when no line gave a whole version.*/
+static int _readVersion(const QRBinaryImage *img, int shift,
+                        const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c)
+{
+	double line[4];
+	int votes[41];
+	int estimate;
+	int changes;
+	int steps;
+	int last;
+	int cur;
+	int best;
+	int arm;
+	int v;
+	int i;
+	int k;
+
+	estimate = _estimateVersion(a, b, c);
+	memset(votes, 0, sizeof(votes));
+	for (arm = 0; arm < 2; ++arm){
+		for (k = -1; k <= 1; ++k){
+			if (0 == arm){
+				_timingLine(a, b, c, k, line);
+			} else {
+				_timingLine(a, c, b, k, line);
+			}
+
+			steps = (int)(sqrt(line[2] * line[2] + line[3] * line[3]) / QR_TO_CALC(1 << shift));
+			last = -1;
+			changes = 0;
+			for (i = 0; i <= steps; ++i){
+				cur = _sampleBlack(img, shift, line[0] + line[2] * i / steps, line[1] + line[3] * i / steps);
+				if (cur < 0){
+					break;
+				}
+				if (last >= 0 && cur != last){
+					changes += 1;
+				}
+				last = cur;
+			}
+
+			v = changes / 4 - 1;
+			if (i > steps && 0 == (changes & 3) && v >= 1 && v <= 40){
+				votes[v] += 1;
+			}
+		}
+	}
+
+	//票数相同时取离估计值近的
+	best = estimate;
+	for (v = 1; v <= 40; ++v){
+		if (votes[v] > votes[best] || (votes[v] == votes[best] && abs(v - estimate) < abs(best - estimate))){
+			best = v;
+		}
+	}
+
+	return best;
+}
+
+//以精确坐标(x, y)为中心，按模块向量u、v取样的5x5个模块中符合校正图形的个数
+static int _alignmentScore(const QRBinaryImage *img, int shift, double x, double y,
+                           double ux, double uy, double vx, double vy)
+{
+	int score;
+	int black;
+	int i;
+	int j;
+
+	score = 0;
+	for (j = -2; j <= 2; ++j){
+		for (i = -2; i <= 2; ++i){
+			//中间一圈是白色
+			black = _sampleBlack(img, shift, x + i * ux + j * vx, y + i * uy + j * vy);
+			if (black == (1 != MAX(abs(i), abs(j)))){
+				score += 1;
+			}
+		}
+	}
+
+	return score;
+}
+
+/*Look for the alignment pattern in the bottom right corner of a code,
+   centered on module (size - 6.5, size - 6.5), around (x, y).
+  Candidates are scored by how many of the 5 x 5 modules of the pattern, a
+   black center in a white ring in a black ring, they match on the binary
+   frame scaled down by shift, with the module steps of the affine
+   transform tr. Perspective changes the module width there from that of
+   tr as well, scale corrects it.
+  They are tried every half module up to 4 modules away, then 8 and 16 as
+   long as none matched, perspective moves the pattern that far from the
+   guess on large codes, and then every quarter module around the best of
+   them.
+  Return: 0 with the mean of the best candidates in x and y, in subpel
+   units, or -1 if none of them matched 24 modules.*/
+static int _findAlignment(const QRBinaryImage *img, int shift, const QRCodeTransform *tr, double scale, double *x, double *y)
+{
+	double px;
+	double py;
+	double ux;
+	double uy;
+	double vx;
+	double vy;
+	double cx;
+	double cy;
+	double sumx;
+	double sumy;
+	int best;
+	int nbest;
+	int score;
+	int r;
+	int s;
+	int t;
+
+	_mapModule(tr->h, tr->size - 6.5, tr->size - 6.5, &px, &py);
+	_mapModule(tr->h, tr->size - 5.5, tr->size - 6.5, &ux, &uy);
+	_mapModule(tr->h, tr->size - 6.5, tr->size - 5.5, &vx, &vy);
+	ux = (ux - px) * scale;
+	uy = (uy - py) * scale;
+	vx = (vx - px) * scale;
+	vy = (vy - py) * scale;
+	px = *x;
+	py = *y;
+
+	best = 0;
+	cx = px;
+	cy = py;
+	for (r = 8; r <= 32 && best < 24; r *= 2){
+		for (t = -r; t <= r; ++t){
+			for (s = -r; s <= r; ++s){
+				//上一轮已经试过的
+				if (r > 8 && abs(s) <= r / 2 && abs(t) <= r / 2){
+					continue;
+				}
+
+				score = _alignmentScore(img, shift, px + (s * ux + t * vx) / 2, py + (s * uy + t * vy) / 2, ux, uy, vx, vy);
+				if (score > best){
+					best = score;
+					cx = px + (s * ux + t * vx) / 2;
+					cy = py + (s * uy + t * vy) / 2;
+				}
+			}
+		}
+	}
+	if (best < 24){
+		return -1;
+	}
+
+	best = 0;
+	nbest = 0;
+	sumx = 0;
+	sumy = 0;
+	for (t = -4; t <= 4; ++t){
+		for (s = -4; s <= 4; ++s){
+			px = cx + (s * ux + t * vx) / 4;
+			py = cy + (s * uy + t * vy) / 4;
+			score = _alignmentScore(img, shift, px, py, ux, uy, vx, vy);
+			if (score > best){
+				best = score;
+				nbest = 0;
+				sumx = 0;
+				sumy = 0;
+			}
+			if (score == best){
+				nbest += 1;
+				sumx += px;
+				sumy += py;
+			}
+		}
+	}
+
+	*x = sumx / nbest;
+	*y = sumy / nbest;
+
+	return 0;
+}
+
+/*The transform of a code of the given version with its corner finder at a,
+   b along the top edge and c along the left edge.
+  The three finders give an affine transform, which puts the fourth corner
+   where the parallelogram closes. From version 2 on the alignment pattern
+   near that corner is looked for and, when found, takes the place of the
+   fourth point, which corrects the perspective.
+  Under perspective the module width changes across the code by about the
+   same factor from a to b as from c to the fourth corner, so the widths of
+   the finders tell the width the alignment pattern is looked for at.*/
+static void _estimateTransform(const QRBinaryImage *img, int shift,
+                               const QRFinderCenter *a, const QRFinderCenter *b, const QRFinderCenter *c,
+                               int version, QRCodeTransform *tr)
+{
+	double src[4][2];
+	double dst[4][2];
+	double h[9];
+	double scale;
+	double wb;
+	double wc;
+	double x;
+	double y;
+
+	tr->size = 4 * version + 17;
+	tr->aligned = 0;
+
+	src[0][0] = 3.5;
+	src[0][1] = 3.5;
+	src[1][0] = tr->size - 3.5;
+	src[1][1] = 3.5;
+	src[2][0] = 3.5;
+	src[2][1] = tr->size - 3.5;
+	src[3][0] = tr->size - 3.5;
+	src[3][1] = tr->size - 3.5;
+	dst[0][0] = a->pos[0];
+	dst[0][1] = a->pos[1];
+	dst[1][0] = b->pos[0];
+	dst[1][1] = b->pos[1];
+	dst[2][0] = c->pos[0];
+	dst[2][1] = c->pos[1];
+
+	dst[3][0] = b->pos[0] + c->pos[0] - a->pos[0];
+	dst[3][1] = b->pos[1] + c->pos[1] - a->pos[1];
+
+	//_scoreTriple已经保证三个center不在一条线上
+	_solveTransform(src, dst, tr->h);
+	if (version < 2){
+		return;
+	}
+
+	//模块宽度和透视变换的分母成反比，由finder的宽度得出分母沿两条边的变化，估计第四个角
+	wb = (double)a->len / MAX(1, b->len);
+	wc = (double)a->len / MAX(1, c->len);
+	wb = MAX(0.7, MIN(1.4, wb));
+	wc = MAX(0.7, MIN(1.4, wc));
+	dst[3][0] = (b->pos[0] * wb + c->pos[0] * wc - a->pos[0]) / (wb + wc - 1);
+	dst[3][1] = (b->pos[1] * wb + c->pos[1] * wc - a->pos[1]) / (wb + wc - 1);
+	_solveTransform(src, dst, h);
+	_mapModule(h, tr->size - 6.5, tr->size - 6.5, &x, &y);
+
+	//仿射变换的模块宽度是三个finder的平均
+	scale = (double)b->len * c->len / MAX(1, a->len) * 3 / MAX(1, a->len + b->len + c->len);
+	scale = MAX(0.7, MIN(1.4, scale));
+	if (0 != _findAlignment(img, shift, tr, scale, &x, &y)){
+		return;
+	}
+
+	dst[3][0] = x;
+	dst[3][1] = y;
+	src[3][0] = tr->size - 6.5;
+	src[3][1] = tr->size - 6.5;
+	if (0 == _solveTransform(src, dst, h)){
+		memcpy(tr->h, h, sizeof(h));
+		tr->aligned = 1;
+	}
+
+	return;
+}
+
+/*Warp a code upright into a side x side image, QR_CONFIG_RECTIFY_MODULE
+   pixels per module with QR_CONFIG_RECTIFY_QUIET modules of quiet zone
+   around it.
+  Every pixel is interpolated bilinearly from gray, the part of the frame
+   at (x0, y0); what falls outside it is white.*/
+static void _warpCode(const Mat &gray, int x0, int y0, const QRCodeTransform *tr, unsigned char *dst, int side)
+{
+	const unsigned char *data;
+	const unsigned char *p;
+	const double *h;
+	unsigned char *line;
+	size_t stride;
+	double step;
+	double u;
+	double v;
+	double nx;
+	double ny;
+	double w;
+	double dx;
+	double dy;
+	double dw;
+	double rw;
+	double fx;
+	double fy;
+	int cols;
+	int rows;
+	int top;
+	int bottom;
+	int wx;
+	int wy;
+	int ix;
+	int iy;
+	int x;
+	int y;
+
+	//写dst时编译器无法确定gray没有变化，先取到局部变量
+	data = gray.data;
+	stride = gray.step;
+	cols = gray.cols;
+	rows = gray.rows;
+	h = tr->h;
+	step = 1.0 / QR_CONFIG_RECTIFY_MODULE;
+	dx = h[0] * step;
+	dy = h[3] * step;
+	dw = h[6] * step;
+	for (y = 0; y < side; ++y){
+		//分子分母都是u的线性函数，沿一行递增
+		u = step / 2 - QR_CONFIG_RECTIFY_QUIET;
+		v = (y + 0.5) * step - QR_CONFIG_RECTIFY_QUIET;
+		nx = h[0] * u + h[1] * v + h[2];
+		ny = h[3] * u + h[4] * v + h[5];
+		w = h[6] * u + h[7] * v + h[8];
+		line = dst + (size_t)y * side;
+		for (x = 0; x < side; ++x, nx += dx, ny += dy, w += dw){
+			rw = QR_TO_ACTUAL_F(1 / w);
+			fx = nx * rw - x0;
+			fy = ny * rw - y0;
+			if (fx < 0 || fy < 0){
+				line[x] = QR_COLOR_WHITE;
+				continue;
+			}
+
+			//已经排除了负数，取整即向下取整
+			ix = (int)fx;
+			iy = (int)fy;
+			if (ix + 1 >= cols || iy + 1 >= rows){
+				line[x] = QR_COLOR_WHITE;
+				continue;
+			}
+
+			//8位定点的双线性插值
+			wx = (int)((fx - ix) * 256);
+			wy = (int)((fy - iy) * 256);
+			p = data + (size_t)iy * stride + ix;
+			top = p[0] * (256 - wx) + p[1] * wx;
+			bottom = p[stride] * (256 - wx) + p[stride + 1] * wx;
+			line[x] = (unsigned char)((top * (256 - wy) + bottom * wy + (1 << 15)) >> 16);
+		}
+	}
+
+	return;
+}
+
+/*Sample every module of a code at its center on the binary frame, scaled
+   down by shift, into bits, words 64-bit words per row. Modules outside the
+   frame are taken as white.*/
+static void _sampleGrid(const QRBinaryImage *img, int shift, const QRCodeTransform *tr, uint64_t *bits, int words)
+{
+	const double *h;
+	uint64_t *row;
+	double nx;
+	double ny;
+	double w;
+	int x;
+	int y;
+
+	h = tr->h;
+	memset(bits, 0, sizeof(uint64_t) * words * tr->size);
+	for (y = 0; y < tr->size; ++y){
+		//和_warpCode一样，分子分母沿一行递增
+		nx = h[0] * 0.5 + h[1] * (y + 0.5) + h[2];
+		ny = h[3] * 0.5 + h[4] * (y + 0.5) + h[5];
+		w = h[6] * 0.5 + h[7] * (y + 0.5) + h[8];
+		row = bits + (size_t)y * words;
+		for (x = 0; x < tr->size; ++x, nx += h[0], ny += h[3], w += h[6]){
+			if (1 == _sampleBlack(img, shift, nx / w, ny / w)){
+				row[x >> 6] |= (uint64_t)1 << (x & 63);
+			}
+		}
+	}
+
+	return;
+}
+
+/*Count the modules of a sampled grid that differ from the function
+   patterns every code has: the three finders with their separators and
+   the two timing patterns.*/
+static int _gridErrors(const QRCodeGrid *grid)
+{
+	int corner[3][2];
+	int errors;
+	int ring;
+	int x;
+	int y;
+	int i;
+	int j;
+	int k;
+
+	corner[0][0] = 0;
+	corner[0][1] = 0;
+	corner[1][0] = grid->size - 7;
+	corner[1][1] = 0;
+	corner[2][0] = 0;
+	corner[2][1] = grid->size - 7;
+
+	//finder从中心向外是3x3黑、白环、黑环，再外面一圈是白色的分隔符
+	errors = 0;
+	for (k = 0; k < 3; ++k){
+		for (j = -1; j <= 7; ++j){
+			for (i = -1; i <= 7; ++i){
+				x = corner[k][0] + i;
+				y = corner[k][1] + j;
+				if (x < 0 || y < 0 || x >= grid->size || y >= grid->size){
+					continue;
+				}
+				ring = MAX(abs(i - 3), abs(j - 3));
+				errors += QR_GRID_MODULE(grid, x, y) != (ring != 2 && ring != 4);
+			}
+		}
+	}
+
+	//定位图形在第6行和第6列，偶数位置为黑
+	for (i = 8; i < grid->size - 8; ++i){
+		errors += QR_GRID_MODULE(grid, i, 6) != !(i & 1);
+		errors += QR_GRID_MODULE(grid, 6, i) != !(i & 1);
+	}
+
+	return errors;
+}
+
+//二维码上边从左到右的方向，按最接近的90度计
+static int _gridOrientation(const QRCodeTransform *tr)
+{
+	double x0;
+	double y0;
+	double x1;
+	double y1;
+
+	_mapModule(tr->h, 3.5, 3.5, &x0, &y0);
+	_mapModule(tr->h, tr->size - 3.5, 3.5, &x1, &y1);
+
+	//图像y轴向下，角度增大是顺时针
+	return (int)floor(atan2(y1 - y0, x1 - x0) / (CV_PI / 2) + 0.5) & 3;
+}
+
+static int _compareTriples(const void *a, const void *b)
+{
+	const QRTriple *ta;
+	const QRTriple *tb;
+	int k;
+
+	ta = (const QRTriple *)a;
+	tb = (const QRTriple *)b;
+	if (ta->inside != tb->inside){
+		return ta->inside - tb->inside;
+	}
+	if (ta->score != tb->score){
+		return (ta->score < tb->score) ? -1 : 1;
+	}
+
+	for (k = 0; k < 3; ++k){
+		if (ta->center[k] != tb->center[k]){
+			return ta->center[k] - tb->center[k];
+		}
+	}
+
+	return 0;
+}
+
+/*The crop around the corners minx .. maxx, miny .. maxy, in subpel units,
+   padded by 8/3 of the center width len on each side and clipped to the
+   width * height frame.*/
+static void _setCropRect(QRCodeRegion *region, int minx, int miny, int maxx, int maxy, int len, int width, int height)
+{
+	//finder中心黑块宽3个模块，向外扩张8个模块
+	len = QR_TO_ACTUAL(len*8/3);
+	minx = QR_TO_ACTUAL(minx);
+	miny = QR_TO_ACTUAL(miny);
+	maxx = QR_TO_ACTUAL(maxx);
+	maxy = QR_TO_ACTUAL(maxy);
+
+	minx = MAX(0, minx - len);
+	miny = MAX(0, miny - len);
+	maxx = (maxx + len < width) ? maxx + len : width;
+	maxy = (maxy + len < height) ? maxy + len : height;
+
+	region->x = minx;
+	region->y = miny;
+	region->width = maxx - minx;
+	region->height = maxy - miny;
+
+	return;
+}
+
+/*The crop of a code from its three finders.
+  The fourth corner is taken to close the parallelogram, so tilted codes are
+   covered as well.*/
+static void _cropCode(const QRFinderCenter *centers, QRCodeRegion *region, int width, int height)
+{
+	const QRFinderCenter *a;
+	const QRFinderCenter *b;
+	const QRFinderCenter *c;
+	int dx;
+	int dy;
+
+	a = centers + region->center[0];
+	b = centers + region->center[1];
+	c = centers + region->center[2];
+	dx = b->pos[0] + c->pos[0] - a->pos[0];
+	dy = b->pos[1] + c->pos[1] - a->pos[1];
+	_setCropRect(region,
+	             MIN(MIN(a->pos[0], b->pos[0]), MIN(c->pos[0], dx)),
+	             MIN(MIN(a->pos[1], b->pos[1]), MIN(c->pos[1], dy)),
+	             MAX(MAX(a->pos[0], b->pos[0]), MAX(c->pos[0], dx)),
+	             MAX(MAX(a->pos[1], b->pos[1]), MAX(c->pos[1], dy)),
+	             (a->len + b->len + c->len) / 3, width, height);
+
+	return;
+}
+
+/*The crop of a rectified code: the part of the frame its transform maps
+   the code and its quiet zone from, with a pixel to spare for the
+   interpolation.*/
+static void _rectifyRect(const QRCodeTransform *tr, QRCodeRegion *region, int width, int height)
+{
+	double x;
+	double y;
+	double minx;
+	double miny;
+	double maxx;
+	double maxy;
+	int k;
+
+	minx = miny = 1e18;
+	maxx = maxy = -1e18;
+	for (k = 0; k < 4; ++k){
+		_mapModule(tr->h, (k & 1) ? tr->size + QR_CONFIG_RECTIFY_QUIET : -QR_CONFIG_RECTIFY_QUIET,
+		           (k & 2) ? tr->size + QR_CONFIG_RECTIFY_QUIET : -QR_CONFIG_RECTIFY_QUIET, &x, &y);
+		minx = MIN(minx, x);
+		miny = MIN(miny, y);
+		maxx = MAX(maxx, x);
+		maxy = MAX(maxy, y);
+	}
+
+	//限制在图像范围内再取整，避免透视变换把角点投到很远处时溢出
+	minx = MAX(0.0, minx - QR_TO_CALC(1));
+	miny = MAX(0.0, miny - QR_TO_CALC(1));
+	maxx = MIN((double)QR_TO_CALC(width), maxx + QR_TO_CALC(2));
+	maxy = MIN((double)QR_TO_CALC(height), maxy + QR_TO_CALC(2));
+	_setCropRect(region, (int)minx, (int)miny, (int)maxx, (int)maxy, 0, width, height);
+	region->side = (tr->size + 2 * QR_CONFIG_RECTIFY_QUIET) * QR_CONFIG_RECTIFY_MODULE;
+
+	return;
+}
+
+/*Group the centers into codes.
+  Every center is tried as the corner of a code with each pair of its
+   nearest QR_CONFIG_GROUP_NEIGHBORS centers, found through a grid, so the
+   cost stays linear in the number of centers. A triple must pass
+   _scoreTriple and show both timing patterns on the binary frame; the
+   triples are then taken with the fewest other centers inside first and
+   the best score next, each center going to one code only.
+  With rectify or grid set in the config the transform of each code is
+   estimated as well, see _estimateTransform.
+  Without any code, a single region covers all the centers as before.*/
+void QRLocator::_groupCenters(int width, int height)
+{
+	QRCenterGrid grid;
+	QRTriple *triples;
+	QRTriple *t;
+	QRCodeRegion *region;
+	int nearest[QR_CONFIG_GROUP_NEIGHBORS];
+	char *used;
+	int64_t radius;
+	double score;
+	double timing;
+	int ntriples;
+	int nnear;
+	int minx;
+	int miny;
+	int maxx;
+	int maxy;
+	int len;
+	int n;
+	int i;
+	int j;
+	int k;
+
+	n = m_nCenters;
+	triples = (QRTriple *)_growBuffer(m_GroupBuf, 0,
+	                                  sizeof(QRTriple) * n * QR_CONFIG_GROUP_NEIGHBORS * (QR_CONFIG_GROUP_NEIGHBORS - 1) / 2 +
+	                                  sizeof(int) * (5 * n + 5) + n);
+	grid.start = (int *)(triples + n * QR_CONFIG_GROUP_NEIGHBORS * (QR_CONFIG_GROUP_NEIGHBORS - 1) / 2);
+	grid.order = grid.start + 4 * n + 5;
+	used = (char *)(grid.order + n);
+	_buildCenterGrid(m_Centers, n, &grid);
+
+	ntriples = 0;
+	for (i = 0; i < n; ++i){
+		//版本40的两个finder相距170个模块
+		radius = (int64_t)m_Centers[i].len * 170 / 3 * (100 + QR_CONFIG_GROUP_TOLERANCE) / 100;
+		nnear = _nearestCenters(m_Centers, &grid, i, radius, nearest, QR_CONFIG_GROUP_NEIGHBORS);
+		for (j = 0; j < nnear; ++j){
+			for (k = j + 1; k < nnear; ++k){
+				score = _scoreTriple(m_Centers + i, m_Centers + nearest[j], m_Centers + nearest[k]);
+				if (score < 0){
+					continue;
+				}
+
+				//图像y轴向下，从上边的finder转到左边的finder是顺时针
+				t = triples + ntriples++;
+				t->score = score;
+				t->center[0] = i;
+				if ((int64_t)(m_Centers[nearest[j]].pos[0] - m_Centers[i].pos[0]) * (m_Centers[nearest[k]].pos[1] - m_Centers[i].pos[1]) >=
+				    (int64_t)(m_Centers[nearest[j]].pos[1] - m_Centers[i].pos[1]) * (m_Centers[nearest[k]].pos[0] - m_Centers[i].pos[0])){
+					t->center[1] = nearest[j];
+					t->center[2] = nearest[k];
+				} else {
+					t->center[1] = nearest[k];
+					t->center[2] = nearest[j];
+				}
+
+				//相邻二维码的finder之间只有静区，没有定位图形
+				timing = MIN(_timingFit(&m_Frame, m_nLevels, m_Centers + t->center[0], m_Centers + t->center[1], m_Centers + t->center[2]),
+				             _timingFit(&m_Frame, m_nLevels, m_Centers + t->center[0], m_Centers + t->center[2], m_Centers + t->center[1]));
+				if (timing < 0.75){
+					ntriples -= 1;
+					continue;
+				}
+				t->score += 1 - timing;
+				t->inside = _countInside(m_Centers, &grid, t);
+			}
+		}
+	}
+	qsort(triples, ntriples, sizeof(QRTriple), _compareTriples);
+
+	//最多n/3个二维码，没有时用一个包含所有center的范围，按对齐要求从大到小排列
+	m_Transforms = (QRCodeTransform *)_growBuffer(m_CodeBuf, 0, MAX(1, n / 3) * (sizeof(QRCodeTransform) + sizeof(size_t) + sizeof(QRCodeRegion)));
+	m_CropOffsets = (size_t *)(m_Transforms + MAX(1, n / 3));
+	m_Codes = (QRCodeRegion *)(m_CropOffsets + MAX(1, n / 3));
+	m_nCodes = 0;
+	memset(used, 0, n);
+	for (i = 0; i < ntriples; ++i){
+		t = triples + i;
+		if (used[t->center[0]] || used[t->center[1]] || used[t->center[2]]){
+			continue;
+		}
+
+		region = m_Codes + m_nCodes;
+		for (k = 0; k < 3; ++k){
+			used[t->center[k]] = 1;
+			region->center[k] = t->center[k];
+		}
+		region->version = _readVersion(&m_Frame, m_nLevels, m_Centers + t->center[0], m_Centers + t->center[1], m_Centers + t->center[2]);
+		region->side = 0;
+		if (m_Config.rectify || m_Config.grid){
+			_estimateTransform(&m_Frame, m_nLevels, m_Centers + t->center[0], m_Centers + t->center[1], m_Centers + t->center[2],
+			                   region->version, m_Transforms + m_nCodes);
+		}
+		if (m_Config.rectify){
+			_rectifyRect(m_Transforms + m_nCodes, region, width, height);
+		} else {
+			_cropCode(m_Centers, region, width, height);
+		}
+		m_nCodes += 1;
+	}
+
+	if (0 == m_nCodes){
+		minx = 0x7FFFFFFF;
+		miny = 0x7FFFFFFF;
+		maxx = 0;
+		maxy = 0;
+		len = 0;
+		for (i = 0; i < n; ++i){
+			minx = MIN(minx, m_Centers[i].pos[0]);
+			miny = MIN(miny, m_Centers[i].pos[1]);
+			maxx = MAX(maxx, m_Centers[i].pos[0]);
+			maxy = MAX(maxy, m_Centers[i].pos[1]);
+			len += m_Centers[i].len;
+		}
+
+		region = m_Codes + m_nCodes++;
+		region->center[0] = -1;
+		region->center[1] = -1;
+		region->center[2] = -1;
+		region->version = 0;
+		region->side = 0;
+		_setCropRect(region, minx, miny, maxx, maxy, len / n, width, height);
+	}
+
+	return;
+}
+
+/*Sample the module grid of every code found from three centers into
+   m_GridBuf, the grids first and their bits after them.
+  The fallback region has no transform and gets an empty grid.*/
+void QRLocator::_sampleGrids(void)
+{
+	QRCodeGrid *grid;
+	uint64_t *bits;
+	size_t total;
+	int i;
+
+	total = 0;
+	for (i = 0; i < m_nCodes; ++i){
+		if (m_Codes[i].center[0] >= 0){
+			total += (size_t)m_Transforms[i].size * QR_BITMAP_WORDS(m_Transforms[i].size);
+		}
+	}
+
+	//QRCodeGrid中有指针，后面的uint64_t自然对齐
+	m_Grids = (QRCodeGrid *)_growBuffer(m_GridBuf, 0, sizeof(QRCodeGrid) * m_nCodes + sizeof(uint64_t) * total);
+	bits = (uint64_t *)(m_Grids + m_nCodes);
+	for (i = 0; i < m_nCodes; ++i){
+		grid = m_Grids + i;
+		memset(grid, 0, sizeof(*grid));
+		grid->version = m_Codes[i].version;
+		if (m_Codes[i].center[0] < 0){
+			continue;
+		}
+
+		grid->size = m_Transforms[i].size;
+		grid->words = QR_BITMAP_WORDS(grid->size);
+		grid->bits = bits;
+		bits += (size_t)grid->size * grid->words;
+		_sampleGrid(&m_Frame, m_nLevels, m_Transforms + i, grid->bits, grid->words);
+		grid->orientation = _gridOrientation(m_Transforms + i);
+		grid->errors = _gridErrors(grid);
+	}
+
+	return;
+}
+
+/*Crop every code out of raw into m_CropBuf, one after another, or warp it
+   there when it has a transform.
+  qrimg is set to the first of them.
+  Return: 0 if a QR square was cropped, otherwise -1.*/
+int QRLocator::_findQRSquare(Mat &raw, Mat &qrimg)
+{
+	QRCodeRegion *region;
+	unsigned char *base;
+	size_t total;
+	Mat crop;
+	Mat gray;
+	int i;
+
+	m_nCodes = 0;
+	m_Grids = NULL;
+	if (m_nCenters < 3){
+		return -1;
+	}
+
+	_groupCenters(raw.cols, raw.rows);
+	if (m_Config.grid){
+		_sampleGrids();
+	}
+
+	total = 0;
+	for (i = 0; i < m_nCodes; ++i){
+		m_CropOffsets[i] = total;
+		if (m_Codes[i].side > 0){
+			total += (size_t)m_Codes[i].side * m_Codes[i].side;
+		} else {
+			total += (size_t)m_Codes[i].width * m_Codes[i].height;
+		}
+	}
+	base = _reserveMat(m_CropBuf, 1, (int)MAX((size_t)1, total), CV_8UC1).data;
+
+	for (i = 0; i < m_nCodes; ++i){
+		region = m_Codes + i;
+		Mat _tmp(raw, Rect(region->x, region->y, region->width, region->height));
+		if (region->side > 0){
+			//彩色原图只转换变换用到的部分
+			if (1 == _tmp.channels()){
+				gray = _tmp;
+			} else {
+				gray = _reserveMat(m_WarpBuf, region->height, region->width, CV_8UC1);
+				cvtColor(_tmp, gray, CV_RGB2GRAY);
+			}
+			_warpCode(gray, region->x, region->y, m_Transforms + i, base + m_CropOffsets[i], region->side);
+			continue;
+		}
+
+		crop = Mat(region->height, region->width, CV_8UC1, base + m_CropOffsets[i]);
+		if (1 == _tmp.channels()){
+			_tmp.copyTo(crop);
+		} else {
+			//直接从彩色原图裁剪时只转换裁剪出来的部分
+			cvtColor(_tmp, crop, CV_RGB2GRAY);
+		}
+	}
+	qrimg = CodeImage(0);
+
+	return 0;
+}
+
+Mat QRLocator::CodeImage(int index) const
+{
+	const QRCodeRegion *region;
+
+	if (index < 0 || index >= m_nCodes){
+		return Mat();
+	}
+
+	region = m_Codes + index;
+	if (region->side > 0){
+		return Mat(region->side, region->side, CV_8UC1, m_CropBuf.data + m_CropOffsets[index]);
+	}
+
+	return Mat(region->height, region->width, CV_8UC1, m_CropBuf.data + m_CropOffsets[index]);
+}
+
+void QRLocator::SaveCodes(Mat &buf, QRFinderCenter **centers, int *ncenters, QRCodeRegion **codes, int *ncodes) const
+{
+	size_t need;
+
+	//二维码放在前面，QRCodeRegion只有int，对齐要求不高于QRFinderCenter
+	need = sizeof(QRCodeRegion) * m_nCodes + sizeof(QRFinderCenter) * m_nCenters;
+	if (buf.empty() || buf.total() < need){
+		buf.create(1, (int)MAX((size_t)1, need), CV_8UC1);
+	}
+
+	*codes = (QRCodeRegion *)buf.data;
+	*ncodes = m_nCodes;
+	memcpy(*codes, m_Codes, sizeof(QRCodeRegion) * m_nCodes);
+	*centers = (QRFinderCenter *)(*codes + m_nCodes);
+	*ncenters = m_nCenters;
+	memcpy(*centers, m_Centers, sizeof(QRFinderCenter) * m_nCenters);
+
+	return;
 }
 
-//finder line
-static void _findCenters(void)
-{	
-	//
-	g_nXClusters = _clusterLines(g_XLines, g_XLineSize, g_XNeighbors, g_XClusters, 0);
-	g_nYClusters = _clusterLines(g_YLines, g_YLineSize, g_YNeighbors, g_YClusters, 1);
+void QRLocator::SaveGrids(Mat &buf, QRCodeGrid **grids, int *ngrids) const
+{
+	uint64_t *bits;
+	size_t need;
+	int n;
+	int i;
 
-	
-	//жclusterǷ񽻲
-	g_nCenters = _findCrossing(g_Centers, sizeof(g_Centers)/sizeof(g_Centers[0]),
-    						  g_XClusters, g_nXClusters,
-    						  g_YClusters, g_nYClusters,
-    						  g_XCNeighbors, g_YCNeighbors);
+	n = (NULL == m_Grids) ? 0 : m_nCodes;
+	*grids = NULL;
+	*ngrids = n;
+	if (0 == n){
+		return;
+	}
+
+	//位紧跟在grid后面，一起复制再改指针
+	need = sizeof(QRCodeGrid) * n;
+	for (i = 0; i < n; ++i){
+		need += sizeof(uint64_t) * m_Grids[i].size * m_Grids[i].words;
+	}
+	if (buf.empty() || buf.total() < need){
+		buf.create(1, (int)need, CV_8UC1);
+	}
+
+	*grids = (QRCodeGrid *)buf.data;
+	memcpy(*grids, m_Grids, need);
+	bits = (uint64_t *)(*grids + n);
+	for (i = 0; i < n; ++i){
+		if (NULL != (*grids)[i].bits){
+			(*grids)[i].bits = bits + ((*grids)[i].bits - (const uint64_t *)(m_Grids + n));
+		}
+	}
 
 	return;
 }
 
-//ҳQR򲢽м
-static int _findQRSquare(Mat &raw, Mat &qrimg)
-{	
-	int minx;
-	int miny;
-	int maxx;
-	int maxy;
+//在buf中取出一块rows*cols的图像，只有buf不够大时才重新分配
+Mat QRLocator::_reserveMat(Mat &buf, int rows, int cols, int type)
+{
+	size_t need;
+
+	need = (size_t)rows * cols * CV_ELEM_SIZE(type);
+	if (buf.empty() || buf.total() < need){
+		buf.create(1, (int)need, CV_8UC1);
+		m_nAllocs += 1;
+	}
+
+	return Mat(rows, cols, type, buf.data);
+}
+
+void QR_GetDefaultConfig(QRLocatorConfig *config)
+{
+	memset(config, 0, sizeof(*config));
+	config->vscan = QR_VSCAN_ROWMAJOR;
+	config->pyramid = 0;
+	config->threshold = QR_THRESHOLD_FUSED;
+	config->binary_out = 0;
+	config->morph_close = 1;
+	config->min_run_px = 0;
+	config->threads = 0;
+	config->max_centers = 0;
+	config->rectify = 0;
+	config->grid = 0;
+
+	return;
+}
+
+QRLocator::QRLocator()
+{
+	QR_GetDefaultConfig(&m_Config);
+	m_Pool = NULL;
+	m_OwnPool = 1;
+	m_nLevels = 0;
+	memset(&m_Frame, 0, sizeof(m_Frame));
+	m_nScannedPixels = 0;
+	m_nScannedRows = 0;
+	_clusterBegin(&m_XBuilder, 0);
+	_clusterBegin(&m_YBuilder, 1);
+	m_XLines = NULL;
+	m_YLines = NULL;
+	m_XLineSize = 0;
+	m_YLineSize = 0;
+	m_XClusters = NULL;
+	m_YClusters = NULL;
+	m_nXClusters = 0;
+	m_nYClusters = 0;
+	m_Windows = NULL;
+	m_nStripX = 0;
+	m_nStripY = 0;
+	m_Centers = NULL;
+	m_nCenters = 0;
+	m_nDroppedCenters = 0;
+	m_Codes = NULL;
+	m_Transforms = NULL;
+	m_CropOffsets = NULL;
+	m_Grids = NULL;
+	m_nCodes = 0;
+	m_nAllocs = 0;
+}
+
+QRLocator::~QRLocator()
+{
+	if (m_OwnPool){
+		QR_DestroyThreadPool(m_Pool);
+	}
+}
+
+//共用调用者的线程池，NULL时恢复按threads自己创建
+void QRLocator::SetThreadPool(QRThreadPool *pool)
+{
+	if (m_OwnPool){
+		QR_DestroyThreadPool(m_Pool);
+	}
+	m_Pool = pool;
+	m_OwnPool = (NULL == pool);
+
+	return;
+}
+
+int QRLocator::_locate(const QRBinaryImage *img)
+{
+	_scanImage(img, m_Config.min_module_px);
+	_findCenters();
+
+	return m_nCenters;
+}
+
+int QRLocator::LocateBinary(Mat &binary)
+{
+	QRBinaryImage img;
+
+	CV_Assert(true == binary.isContinuous());
+	img.bytes = binary.ptr<uchar>(0);
+	img.bits = NULL;
+	img.words = 0;
+	img.width = binary.cols;
+	img.height = binary.rows;
+
+	return _locate(&img);
+}
+
+//二值图像中从第y行开始的rows行
+static void _subRows(const QRBinaryImage *img, int y, int rows, QRBinaryImage *sub)
+{
+	*sub = *img;
+	sub->height = rows;
+	if (NULL != img->bits){
+		sub->bits = img->bits + (size_t)y * img->words;
+	} else {
+		sub->bytes = img->bytes + (size_t)y * img->width;
+	}
+}
+
+/*Add the lines finished in the current strip to the lines kept from earlier
+   strips.
+  X lines come in row order and are appended; Y lines of the strip are in
+   column order and are merged with the kept ones, which end in earlier
+   rows, so both lists keep the order the clustering needs.*/
+void QRLocator::_addStripLines(QRScanBand *rows, QRScanBand *cols, int y0)
+{
+	QRFinderLine *src;
+	QRFinderLine *kept;
+	QRFinderLine *tmp;
+	Mat swap;
+	int n;
+	int i;
+	int j;
+	int k;
+
+	src = (QRFinderLine *)rows->lines.data;
+	kept = _growLines(m_StripXBuf, m_nStripX, m_nStripX + rows->nlines);
+	for (i = 0; i < rows->nlines; ++i){
+		kept[m_nStripX] = src[i];
+		kept[m_nStripX].pos[1] += QR_TO_CALC(y0);
+		m_nStripX += 1;
+	}
+
+	src = (QRFinderLine *)cols->lines.data;
+	kept = (QRFinderLine *)m_StripYBuf.data;
+	n = m_nStripY + cols->nlines;
+	tmp = _growLines(m_StripTmpBuf, 0, n);
+	for (i = 0, j = 0, k = 0; k < n; ++k){
+		if (j >= cols->nlines || (i < m_nStripY && kept[i].pos[0] <= src[j].pos[0])){
+			tmp[k] = kept[i++];
+		} else {
+			tmp[k] = src[j++];
+		}
+	}
+	swap = m_StripYBuf;
+	m_StripYBuf = m_StripTmpBuf;
+	m_StripTmpBuf = swap;
+	m_nStripY = n;
+
+	return;
+}
+
+//丢掉在limit行之前结束的线，它们不会再属于新的center
+void QRLocator::_dropStripLines(int limit)
+{
+	QRFinderLine *lines;
+	QRFinderLine *l;
+	int n;
+	int i;
+
+	lines = (QRFinderLine *)m_StripXBuf.data;
+	n = 0;
+	for (i = 0; i < m_nStripX; ++i){
+		if (QR_TO_ACTUAL(lines[i].pos[1]) >= limit){
+			lines[n++] = lines[i];
+		}
+	}
+	m_nStripX = n;
+
+	lines = (QRFinderLine *)m_StripYBuf.data;
+	n = 0;
+	for (i = 0; i < m_nStripY; ++i){
+		l = lines + i;
+		if (QR_TO_ACTUAL(l->pos[1] + l->len + l->eoffs) >= limit){
+			lines[n++] = *l;
+		}
+	}
+	m_nStripY = n;
+
+	return;
+}
+
+//重新给保留的线分组
+void QRLocator::_clusterStripLines(void)
+{
+	QRFinderLine *lines;
+	int i;
+
+	lines = (QRFinderLine *)m_StripXBuf.data;
+	_clusterBegin(&m_XBuilder, 0);
+	for (i = 0; i < m_nStripX; ++i){
+		_clusterAdd(&m_XBuilder, lines + i);
+	}
+	m_nXClusters = _clusterEnd(&m_XBuilder, &m_XLines, &m_XLineSize, &m_XClusters);
+
+	lines = (QRFinderLine *)m_StripYBuf.data;
+	_clusterBegin(&m_YBuilder, 1);
+	for (i = 0; i < m_nStripY; ++i){
+		_clusterAdd(&m_YBuilder, lines + i);
+	}
+	m_nYClusters = _clusterEnd(&m_YBuilder, &m_YLines, &m_YLineSize, &m_YClusters);
+
+	return;
+}
+
+/*Locate finder centers in an image streamed from reader in strips of
+   strip rows, holding only about strip + 2 * QR_CONFIG_STRIP_OVERLAP rows of
+   the image at a time.
+  Each strip is binarized with QR_CONFIG_STRIP_OVERLAP extra rows on each
+   side, so its own rows come out exactly as they would from the whole
+   image. Rows are scanned horizontally as usual; the vertical pass is the
+   row-major scan with its per-column state carried from strip to strip.
+  Lines are kept until they end more than one finder height above the
+   strip; the centers of the rows that no later line can reach any more are
+   passed to emit as soon as they are found.
+  The finder height is 7 * max_module_px, or 7 * QR_CONFIG_STRIP_MODULE
+   when max_module_px is 0. The pyramid and threads settings are ignored;
+   a thread pool the locator already has only splits the binarize of each
+   strip into bands.
+  Return: The number of centers found, or -1 if reader failed.*/
+int QRLocator::LocateStrips(QRStripReader reader, void *arg, int width, int height, int channels,
+                            int strip, QRCenterFunc emit, void *emitArg)
+{
+	QRBinaryImage img;
+	QRBinaryImage sub;
+	QRScanBand *rows;
+	QRScanBand *cols;
+	Mat raw;
+	Mat gray;
+	Mat src;
+	int finder;
+	int overlap;
+	int step;
+	int done;
+	int emitted;
+	int keep;
+	int need;
+	int r0;
+	int r1;
+	int y0;
+	int y1;
+	int cy;
 	int i;
-	int len;
 
-	if (g_nCenters < 3){
+	if (NULL == reader || width <= 0 || height <= 0 || (1 != channels && 3 != channels && 4 != channels)){
 		return -1;
 	}
 
-	minx = 0x7FFFFFFF;
-	miny = 0x7FFFFFFF;
-	maxx = 0;
-	maxy = 0;
-	len = 0;
+	overlap = QR_CONFIG_STRIP_OVERLAP;
+	finder = 7 * ((m_Config.max_module_px > 0) ? m_Config.max_module_px : QR_CONFIG_STRIP_MODULE);
+	strip = MAX(strip, 1);
+
+	raw = _reserveMat(m_StripBuf, strip + 2 * overlap, width, CV_8UC(channels));
+	step = (int)raw.step;
+
+	//行方向每段重新开始，列方向的状态跨段保留
+	rows = &m_StripRows;
+	cols = &m_StripCols;
+	rows->start = 0;
+	rows->end = height;
+	rows->nlines = 0;
+	rows->feed = NULL;
+	rows->nhits = 0;
+	rows->scannedRows = 0;
+	rows->scannedPixels = 0;
+	cols->start = 0;
+	cols->end = width;
+	cols->nlines = 0;
+	cols->feed = NULL;
+	cols->scannedRows = 0;
+	cols->scannedPixels = 0;
+	_reserveMat(rows->edges, 1, width, CV_32SC1);
+	_reserveMat(cols->edges, 1, width, CV_32SC1);
+	_reserveMat(m_ColStateBuf, 9, width + 1, CV_32SC1);
+	_resetColumns(cols, width);
+
+	m_nStripX = 0;
+	m_nStripY = 0;
+	m_nScannedRows = 0;
+	m_nScannedPixels = 0;
+	done = 0;
+	emitted = 0;
+	r0 = 0;
+	r1 = 0;
+	for (y0 = 0; y0 < height; y0 = y1){
+		y1 = MIN(height, y0 + strip);
+
+		//上一段末尾和这一段重叠的行移到开头，再读入新的行
+		keep = MAX(0, y0 - overlap);
+		if (keep > r0 && r1 > keep){
+			memmove(raw.data, raw.data + (size_t)(keep - r0) * step, (size_t)(r1 - keep) * step);
+		}
+		r0 = keep;
+		need = MIN(height, y1 + overlap);
+		if (need > r1){
+			if (0 != reader(arg, raw.data + (size_t)(r1 - r0) * step, step, need - r1)){
+				return -1;
+			}
+			r1 = need;
+		}
+
+		src = Mat(r1 - r0, width, CV_8UC(channels), raw.data);
+		gray = _reserveMat(m_GrayBuf, r1 - r0, width, CV_8UC1);
+		_binarize(src, gray, m_BinaryBuf, m_BitBuf, &img);
+
+		//行方向只扫描这一段自己的行
+		_subRows(&img, y0 - r0, y1 - y0, &sub);
+		rows->nlines = 0;
+		for (i = 0; i < sub.height; ++i){
+			_scanRow(rows, &sub, i);
+		}
 
-	//ҳ߿
-	for (i = 0; i < g_nCenters; ++i){
-		if (g_Centers[i].pos[0] < minx){
-			minx = g_Centers[i].pos[0];
+		//列方向和上一行比较，第0行除外
+		_scanColumnRows(cols, &img, r0, MAX(1, y0), y1);
+		_settleColumnHits(cols, width, y1, y1 == height);
+		m_nScannedPixels += width * (y1 - y0);
+
+		_addStripLines(rows, cols, y0);
+
+		//再往下的线到不了这些行
+		need = (y1 == height) ? height : y1 - finder;
+		if (need <= done){
+			continue;
 		}
 
-		if (g_Centers[i].pos[0] > maxx){
-			maxx = g_Centers[i].pos[0];
+		_clusterStripLines();
+		_findCenters();
+		for (i = 0; i < m_nCenters; ++i){
+			cy = QR_TO_ACTUAL(m_Centers[i].pos[1]);
+			if (cy >= done && cy < need){
+				if (NULL != emit){
+					emit(emitArg, m_Centers + i);
+				}
+				emitted += 1;
+			}
 		}
+		done = need;
+
+		_dropStripLines(done - finder);
+	}
+	m_nScannedRows = rows->scannedRows;
+
+	return emitted;
+}
 
-		if (g_Centers[i].pos[1] < miny){
-			miny = g_Centers[i].pos[1];
+/*Convert src to gray and binarize it, removing the noise.
+  gray must already have the size of src.
+  The fused threshold writes a bitmap into bitBuf and closes it with word
+   operations, the OpenCV path writes a byte image into byteBuf; img points
+   at whichever was produced.*/
+void QRLocator::_binarize(Mat &src, Mat &gray, Mat &byteBuf, Mat &bitBuf, QRBinaryImage *img)
+{
+	Mat binary;
+	Mat sums;
+	uint64_t *bits;
+	uint64_t *tmp;
+	int words;
+	int nbands;
+
+	img->width = src.cols;
+	img->height = src.rows;
+
+	if (QR_THRESHOLD_FUSED == m_Config.threshold && CV_8U == src.depth()){
+		words = QR_BITMAP_WORDS(src.cols);
+		bits = (uint64_t *)_reserveMat(bitBuf, src.rows, words * (int)sizeof(uint64_t), CV_8UC1).data;
+		tmp = NULL;
+		if (0 != m_Config.morph_close){
+			tmp = (uint64_t *)_reserveMat(m_BitTmpBuf, src.rows, words * (int)sizeof(uint64_t), CV_8UC1).data;
 		}
 
-		if (g_Centers[i].pos[1] > maxy){
-			maxy = g_Centers[i].pos[1];
+		nbands = (NULL == m_Pool) ? 1 : _splitBands(src.rows, 1, 2 * src.cols, NULL);
+		if (nbands > 1){
+			//分带在线程池上执行，每一步都要等所有带完成，下一步会用到相邻带的行
+			m_Job.src = &src;
+			m_Job.dst = &gray;
+			m_Job.bits = bits;
+			m_Job.tmp = tmp;
+			m_Job.words = words;
+			m_Job.type = QR_SCANJOB_GRAY;
+			QR_RunTasks(m_Pool, _runBand, this, nbands);
+			m_Job.type = QR_SCANJOB_THRESHOLD;
+			QR_RunTasks(m_Pool, _runBand, this, nbands);
+			if (NULL != tmp){
+				m_Job.type = QR_SCANJOB_DILATE;
+				QR_RunTasks(m_Pool, _runBand, this, nbands);
+				m_Job.type = QR_SCANJOB_ERODE;
+				QR_RunTasks(m_Pool, _runBand, this, nbands);
+			}
+		} else {
+			//gray和threshold一遍完成，直接输出位图
+			sums = _reserveMat(m_SumBuf, 2, src.cols, CV_32SC1);
+			QR_GrayThresholdBits(src.data, (int)src.step, src.channels(), src.cols, src.rows,
+			                     gray.data, (int)gray.step, bits, words,
+			                     QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA, (int *)sums.data);
+
+			//消除噪点，每次处理64个像素
+			if (NULL != tmp){
+				QR_CloseBits(bits, bits, tmp, src.cols, src.rows, words);
+			}
 		}
 
-		len += g_Centers[i].len;
+		img->bytes = NULL;
+		img->bits = bits;
+		img->words = words;
+		return;
 	}
 
-	//finderĺڿƾݳ
-	len /= g_nCenters;
-	len = len*8/3;
+	binary = _reserveMat(byteBuf, src.rows, src.cols, CV_8UC1);
 
-	len = QR_TO_ACTUAL(len);
-	minx = QR_TO_ACTUAL(minx);
-	miny = QR_TO_ACTUAL(miny);
-	maxx = QR_TO_ACTUAL(maxx);
-	maxy = QR_TO_ACTUAL(maxy);
+	//gray
+	cvtColor(src, gray, CV_RGB2GRAY);
 
-	//ü߽һߴ
-	if (minx - len >= 0){
-		minx = minx - len;
-	} else {
-		minx = 0;
+	//threshold
+	adaptiveThreshold(gray, binary, QR_COLOR_WHITE, ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY,
+	                  QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA);
+
+	//消除噪点
+	if (0 != m_Config.morph_close){
+		if (m_Elem.empty()){
+			m_Elem = getStructuringElement(MORPH_ELLIPSE, Size(3, 3));
+			m_nAllocs += 1;
+		}
+		morphologyEx(binary, binary, MORPH_CLOSE, m_Elem);
 	}
-	
-	if (miny - len >= 0){
-		miny = miny - len;
-	} else {
-		miny = 0;
+
+	img->bytes = binary.data;
+	img->bits = NULL;
+	img->words = 0;
+
+	return;
+}
+
+//位图只在调用者需要时才展开成每像素1字节的binary
+void QRLocator::_outputBinary(const QRBinaryImage *img, Mat &binary)
+{
+	if (NULL == img->bits){
+		binary = Mat(img->height, img->width, CV_8UC1, (void *)img->bytes);
+		return;
 	}
-	
-	if (maxx + len < raw.cols){
-		maxx = maxx + len;
-	} else {
-		maxx = raw.cols;
+
+	if (0 == m_Config.binary_out){
+		binary = Mat();
+		return;
 	}
 
-	if (maxy + len < raw.rows){
-		maxy = maxy + len;
-	} else {
-		maxy = raw.rows;
+	binary = _reserveMat(m_BinaryBuf, img->height, img->width, CV_8UC1);
+	QR_UnpackBits(img->bits, img->words, img->width, img->height, binary.data, (int)binary.step);
+
+	return;
+}
+
+/*Choose the number of 1/2 downscaling steps for a frame.
+  Large modules are shrunk until the 3 module center fits in the 35 pixel
+   threshold window, large frames are shrunk until they are no larger than
+   QR_CONFIG_PYRAMID_AREA.
+  When min_module_px is given, the smallest module must keep at least
+   QR_CONFIG_MIN_PYRAMID_MODULE pixels; without it only the area counts, so
+   the cost of a frame follows its downscaled size.*/
+static int _pyramidLevels(const QRLocatorConfig *config, int width, int height)
+{
+	int levels;
+	int minModule;
+	int maxModule;
+
+	if (config->pyramid >= 0){
+		return MIN(config->pyramid, QR_CONFIG_MAX_PYRAMID_LEVEL);
 	}
 
-	{
-		Mat _tmp(raw, Rect(minx, miny, maxx - minx, maxy - miny));
-		qrimg = _tmp.clone();
+	minModule = MAX(config->min_module_px, QR_CONFIG_MIN_PYRAMID_MODULE);
+	maxModule = MAX(config->max_module_px, minModule);
+
+	levels = 0;
+	while (levels < QR_CONFIG_MAX_PYRAMID_LEVEL && (maxModule >> levels) > QR_CONFIG_MAX_PYRAMID_MODULE){
+		levels += 1;
 	}
 
-	return 0;
+	while (levels < QR_CONFIG_MAX_PYRAMID_LEVEL &&
+	       (width >> levels) * (height >> levels) > QR_CONFIG_PYRAMID_AREA){
+		levels += 1;
+	}
+
+	//给出了最小模块宽度时，缩小后不能低于下限
+	while (config->min_module_px > 0 && levels > 0 && (minModule >> levels) < QR_CONFIG_MIN_PYRAMID_MODULE){
+		levels -= 1;
+	}
+
+	return levels;
 }
 
-void QR_ProcessImage(Mat &raw, Mat &binary, Mat &qrimg)
+/*Refine the centers found on the downscaled image.
+  Each center is looked up again on a full resolution window two finder
+   widths wide around its scaled position; the closest center found there
+   replaces it, otherwise the scaled position is kept.*/
+void QRLocator::_refineCenters(Mat &raw, int scale)
 {
+	QRFinderCenter *coarse;
+	QRFinderCenter *c;
+	QRBinaryImage img;
+	Mat roi;
 	Mat gray;
-	Mat elem;
+	Rect rect;
+	int ncoarse;
+	int half;
+	int best;
+	int dist;
+	int bestDist;
+	int cx;
+	int cy;
+	int i;
+	int j;
 
-	//gray
-	cvtColor(raw, gray, CV_RGB2GRAY);
+	//窗口中的定位会覆盖m_Centers
+	ncoarse = m_nCenters;
+	coarse = (QRFinderCenter *)_growBuffer(m_CoarseBuf, 0, MAX(1, ncoarse) * sizeof(QRFinderCenter));
+	for (i = 0; i < ncoarse; ++i){
+		coarse[i].pos[0] = m_Centers[i].pos[0] * scale;
+		coarse[i].pos[1] = m_Centers[i].pos[1] * scale;
+		coarse[i].len = m_Centers[i].len * scale;
+	}
 
-	//threshold
-	adaptiveThreshold(gray, binary, QR_COLOR_WHITE, ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY, 35, 5);
-	//imshow("Threadhold", binary);
+	for (i = 0; i < ncoarse; ++i){
+		c = coarse + i;
+		half = MAX(QR_CONFIG_MIN_REFINE_WINDOW / 2, QR_TO_ACTUAL(c->len * 7 / 3));
+		cx = QR_TO_ACTUAL(c->pos[0]);
+		cy = QR_TO_ACTUAL(c->pos[1]);
+		rect.x = MAX(0, cx - half);
+		rect.y = MAX(0, cy - half);
+		rect.width = MIN(raw.cols, cx + half) - rect.x;
+		rect.height = MIN(raw.rows, cy + half) - rect.y;
+		if (rect.width <= 0 || rect.height <= 0){
+			continue;
+		}
+
+		roi = Mat(raw, rect);
+		gray = _reserveMat(m_WinGrayBuf, rect.height, rect.width, CV_8UC1);
+		_binarize(roi, gray, m_WinBinaryBuf, m_WinBitBuf, &img);
+		_locate(&img);
+
+		//找离粗略位置最近的center，距离不超过中心黑块的宽度
+		best = -1;
+		bestDist = c->len * c->len;
+		for (j = 0; j < m_nCenters; ++j){
+			dist = (m_Centers[j].pos[0] + QR_TO_CALC(rect.x) - c->pos[0]) * (m_Centers[j].pos[0] + QR_TO_CALC(rect.x) - c->pos[0]) +
+			       (m_Centers[j].pos[1] + QR_TO_CALC(rect.y) - c->pos[1]) * (m_Centers[j].pos[1] + QR_TO_CALC(rect.y) - c->pos[1]);
+			if (dist <= bestDist){
+				best = j;
+				bestDist = dist;
+			}
+		}
+
+		if (best >= 0){
+			c->pos[0] = m_Centers[best].pos[0] + QR_TO_CALC(rect.x);
+			c->pos[1] = m_Centers[best].pos[1] + QR_TO_CALC(rect.y);
+			c->len = m_Centers[best].len;
+		}
+	}
+
+	m_Centers = (QRFinderCenter *)_growBuffer(m_CenterBuf, 0, MAX(1, ncoarse) * sizeof(QRFinderCenter));
+	memcpy(m_Centers, coarse, sizeof(QRFinderCenter) * ncoarse);
+	m_nCenters = ncoarse;
 
-	//
-	elem = getStructuringElement(MORPH_ELLIPSE, Size(3, 3));
-	morphologyEx(binary, binary, MORPH_CLOSE, elem);
+	return;
+}
+
+/*Binarize the frame, the first stage of ProcessImage.
+  Large frames are first shrunk by 1/2^levels: only the downscaled area and
+   the small refine windows are then processed in full, and the crop is
+   converted from the original frame.
+  The shrink only reads the part of the frame that is a whole multiple of
+   2^levels, so each output row comes from its own rows of the frame and
+   the rows can be shrunk in bands on the thread pool.*/
+int QRLocator::BinarizeFrame(Mat &raw, Mat &binary)
+{
+	Mat &gray = m_Gray;
+	Mat small;
+	Mat whole;
+
+	_preparePool();
+	m_nLevels = _pyramidLevels(&m_Config, raw.cols, raw.rows);
+	if (m_nLevels > 0){
+		small = _reserveMat(m_SmallBuf, raw.rows >> m_nLevels, raw.cols >> m_nLevels, raw.type());
+		whole = Mat(raw, Rect(0, 0, small.cols << m_nLevels, small.rows << m_nLevels));
+		m_Job.type = QR_SCANJOB_SHRINK;
+		m_Job.src = &whole;
+		m_Job.dst = &small;
+		m_Job.levels = m_nLevels;
+		QR_RunTasks(m_Pool, _runBand, this, _splitBands(small.rows, 1, 1, NULL));
+		gray = _reserveMat(m_GrayBuf, small.rows, small.cols, CV_8UC1);
+		_binarize(small, gray, m_BinaryBuf, m_BitBuf, &m_Frame);
+	} else {
+		gray = _reserveMat(m_GrayBuf, raw.rows, raw.cols, CV_8UC1);
+		_binarize(raw, gray, m_BinaryBuf, m_BitBuf, &m_Frame);
+	}
+	_outputBinary(&m_Frame, binary);
 	//imshow("Close", binary);
 
-	//scan image
-	_scanImage(binary);
+	return 0;
+}
+
+//找出finder line，第二个阶段
+void QRLocator::ScanFrame(void)
+{
+	//缩小后的模块宽度
+	_scanImage(&m_Frame, m_Config.min_module_px >> m_nLevels);
+
+	return;
+}
+
+/*Find the centers and crop the code, the last stage of ProcessImage.
+  Centers found on a downscaled frame are refined at full resolution first.
+  Return: 0 if a QR square was cropped, otherwise -1.*/
+int QRLocator::FinishFrame(Mat &raw, Mat &qrimg)
+{
+	int ret;
 
 	//find centers
 	_findCenters();
 
+	if (m_nLevels > 0){
+		_refineCenters(raw, 1 << m_nLevels);
+		ret = _findQRSquare(raw, qrimg);
+
+		//画出点
+		_drawCenters(raw, m_Centers, m_nCenters);
+
+		return ret;
+	}
+
 	//find qr square
-	_findQRSquare(gray, qrimg);
+	ret = _findQRSquare(m_Gray, qrimg);
 
-	//finder line
-	//_drawFinderLines(raw, g_XLines, g_XLineSize, 0);
-	//_drawFinderLines(raw, g_YLines, g_YLineSize, 1);	
+	//画出finder line
+	//_drawFinderLines(raw, m_XLines, m_XLineSize, 0);
+	//_drawFinderLines(raw, m_YLines, m_YLineSize, 1);	
 
-	//cluster
-	_drawCluster(raw, g_XClusters, g_nXClusters, 0);
-	_drawCluster(raw, g_YClusters, g_nYClusters, 1);
+	//画出cluster
+	_drawCluster(raw, m_XClusters, m_nXClusters, 0);
+	_drawCluster(raw, m_YClusters, m_nYClusters, 1);
 
-	//
-	_drawCenters(raw, g_Centers, g_nCenters);
+	//画出点
+	_drawCenters(raw, m_Centers, m_nCenters);
 
-	return;
+	return ret;
+}
+
+int QRLocator::ProcessImage(Mat &raw, Mat &binary, Mat &qrimg)
+{
+	BinarizeFrame(raw, binary);
+	ScanFrame();
+
+	return FinishFrame(raw, qrimg);
+}
+
+QR_LOCATOR QR_CreateLocator(void)
+{
+	return (QR_LOCATOR)(new QRLocator());
+}
+
+void QR_DestroyLocator(QR_LOCATOR locator)
+{
+	delete (QRLocator *)locator;
+}
+
+int QR_Locate(QR_LOCATOR locator, Mat &raw, Mat &binary, Mat &qrimg)
+{
+	if (NULL == locator){
+		return -1;
+	}
+
+	return ((QRLocator *)locator)->ProcessImage(raw, binary, qrimg);
+}
+
+int QR_SetLocatorConfig(QR_LOCATOR locator, const QRLocatorConfig *config)
+{
+	if (NULL == locator || NULL == config){
+		return -1;
+	}
+
+	((QRLocator *)locator)->SetConfig(*config);
+
+	return 0;
+}
+
+int QR_GetAllocCount(QR_LOCATOR locator)
+{
+	if (NULL == locator){
+		return -1;
+	}
+
+	return ((QRLocator *)locator)->AllocCount();
+}
+
+int QR_GetDroppedCenters(QR_LOCATOR locator)
+{
+	if (NULL == locator){
+		return -1;
+	}
+
+	return ((QRLocator *)locator)->DroppedCenters();
+}
+
+int QR_GetCodeCount(QR_LOCATOR locator)
+{
+	if (NULL == locator){
+		return -1;
+	}
+
+	return ((QRLocator *)locator)->CodeCount();
+}
+
+int QR_GetCodeImage(QR_LOCATOR locator, int index, Mat &qrimg)
+{
+	if (NULL == locator || index < 0 || index >= ((QRLocator *)locator)->CodeCount()){
+		return -1;
+	}
+
+	qrimg = ((QRLocator *)locator)->CodeImage(index);
+
+	return 0;
+}
+
+int QR_GetCodeGrid(QR_LOCATOR locator, int index, QRCodeGrid *grid)
+{
+	const QRCodeGrid *grids;
+
+	if (NULL == locator || NULL == grid || index < 0 || index >= ((QRLocator *)locator)->CodeCount()){
+		return -1;
+	}
+
+	grids = ((QRLocator *)locator)->Grids();
+	if (NULL == grids || 0 == grids[index].size){
+		return -1;
+	}
+	*grid = grids[index];
+
+	return 0;
 }
 
+//默认实例，兼容原来的接口
+static QRLocator g_DefaultLocator;
+
+void QR_ProcessImage(Mat &raw, Mat &binary, Mat &qrimg)
+{
+	g_DefaultLocator.ProcessImage(raw, binary, qrimg);
+
+	return;
+}
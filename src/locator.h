@@ -1,20 +1,527 @@
 #ifndef _LOCATOR_H_
 #define _LOCATOR_H_
 
+#include <stdint.h>
+
+#include "threadpool.h"
+
 /*The number of bits of subpel precision to store image coordinates in.
   This helps when estimating positions in low-resolution images, which may have
    a module pitch only a pixel or two wide, making rounding errors matter a
    great deal.*/
 #define QR_FINDER_SUBPREC (2)
 
-//ͬһfindler line
-#define QR_CONFIG_MAX_FINDER_LINE   640
+//金字塔最多缩小的层数，每层缩小一半
+#define QR_CONFIG_MAX_PYRAMID_LEVEL 2
 
-//һ;Finder Center
-#define QR_CONFIG_MAX_FINDER_CENTER 16
+//缩小后模块的最小像素宽度
+#define QR_CONFIG_MIN_PYRAMID_MODULE 2
 
-extern void QR_ProcessImage(Mat &raw, Mat &binary, Mat &qrimg);
+//模块超过这个宽度时中心黑块会超出35像素的二值化窗口
+#define QR_CONFIG_MAX_PYRAMID_MODULE 10
 
-#endif
+//面积超过1080p的图像才自动缩小
+#define QR_CONFIG_PYRAMID_AREA (1920 * 1080)
+
+//在原图上精确定位center时窗口的最小边长
+#define QR_CONFIG_MIN_REFINE_WINDOW 64
+
+//自适应二值化的窗口边长和阈值偏移
+#define QR_CONFIG_THRESHOLD_BLOCK 35
+#define QR_CONFIG_THRESHOLD_DELTA 5
+
+//分段处理时相邻两段重叠的行数，包括二值化窗口的一半和闭运算的一行
+#define QR_CONFIG_STRIP_OVERLAP (QR_CONFIG_THRESHOLD_BLOCK / 2 + 1)
+
+//分段处理时没有给出max_module_px所假设的最大模块宽度
+#define QR_CONFIG_STRIP_MODULE 16
+
+//多线程扫描时每个线程分到的带数，带越多负载越均衡
+#define QR_CONFIG_BANDS_PER_THREAD 4
+#define QR_CONFIG_MAX_SCAN_BANDS   64
+
+//一条带最少的行数或列数
+#define QR_CONFIG_MIN_BAND_SIZE    16
+
+//finder line分组时索引格子的宽度，为2的这个次方个精确坐标，即8个像素
+#define QR_CONFIG_CLUSTER_CELL_SHIFT (QR_FINDER_SUBPREC + 3)
+
+//把center分成三个一组时，每个center只和最近的这么多个center组合
+#define QR_CONFIG_GROUP_NEIGHBORS 8
+
+//三个center的几何关系允许的误差，百分比
+#define QR_CONFIG_GROUP_TOLERANCE 25
+
+//矫正输出时每个模块的像素数和四周静区的模块数
+#define QR_CONFIG_RECTIFY_MODULE 4
+#define QR_CONFIG_RECTIFY_QUIET  4
+
+//point
+typedef int QRPoint[2];
+
+//用于匹配白:黑:白:黑:白:黑:白的模式，宽度比为n:1:1:3:1:1:n
+typedef struct QRFindState{
+	int w[5];
+	int last;
+}QRFindState;
+
+//寻找到的穿过finder的线，根据上下文确定是x方向，还是y方向
+
+/*A line crossing a finder pattern.
+  Whether the line is horizontal or vertical is determined by context.
+  The offsts to various parts of the finder pattern are as follows:
+    |*****|     |*****|*****|*****|     |*****|
+    |*****|     |*****|*****|*****|     |*****|
+       ^        ^                 ^        ^
+       |        |                 |        |
+       |        |                 |       pos[v]+len+eoffs
+       |        |                pos[v]+len
+       |       pos[v]
+      pos[v]-boffs
+  Here v is 0 for horizontal and 1 for vertical lines.*/
+typedef struct QRFinderLine{
+  /*The location of the upper/left endpoint of the line.
+    The left/upper edge of the center section is used, since other lines must
+     cross in this region.*/
+  QRPoint pos;
+  /*The length of the center section.
+    This extends to the right/bottom of the center section, since other lines
+     must cross in this region.*/
+  int      len;
+  /*The offset to the midpoint of the upper/left section (part of the outside
+     ring), or 0 if we couldn't identify the edge of the beginning section.
+    We use the midpoint instead of the edge because it can be located more
+     reliably.*/
+  int      boffs;
+  /*The offset to the midpoint of the end section (part of the outside ring),
+     or 0 if we couldn't identify the edge of the end section.
+    We use the midpoint instead of the edge because it can be located more
+     reliably.*/
+  int      eoffs;
+} QRFinderLine;
+
+/*A cluster of lines crossing a finder pattern (all in the same direction).*/
+typedef struct QRFinderCluster{
+  /*The lines crossing the pattern, stored one after another.*/
+  QRFinderLine  *lines;
+  /*The number of lines in the cluster.*/
+  int          nlines;
+} QRFinderCluster;
+
+typedef struct QRFinderCenter{
+	QRPoint pos; //finder 中心的位置
+	int     len; //finder 中心黑块的宽度
+} QRFinderCenter;
+
+/*One code in the frame: three finder centers that lie like the corners of
+   a code, and the part of the frame to crop for it.
+  center holds indices into the centers of the frame, the corner finder
+   first, then the finder along the top edge and the one along the left edge
+   of the code. They are all -1 when no three centers formed a code and the
+   crop covers every center instead.*/
+typedef struct QRCodeRegion{
+	int center[3];
+	int x;         //裁剪范围，原图的像素坐标
+	int y;
+	int width;
+	int height;
+	int version;   //由定位图形读出的版本，没有三个center时为0
+	int side;      //矫正后图像的边长，0表示直接裁剪x, y, width, height
+} QRCodeRegion;
+
+/*The perspective transform of a code from module coordinates, where module
+   (i, j) covers [i, i + 1) * [j, j + 1) and the finder centers are at 3.5
+   modules from the corners, to subpel frame coordinates:
+    x = (h[0] * u + h[1] * v + h[2]) / (h[6] * u + h[7] * v + h[8])
+    y = (h[3] * u + h[4] * v + h[5]) / (h[6] * u + h[7] * v + h[8])
+  With only the three finders it is affine; aligned is set when the
+   alignment pattern was found and fixes the fourth corner as well.*/
+typedef struct QRCodeTransform{
+	double h[9];
+	int    size;    //每边的模块数，4 * version + 17
+	int    aligned;
+} QRCodeTransform;
+
+/*The modules of a code, each sampled once at its center, row by row from
+   the corner finder, so the code reads upright whichever way it lies in
+   the frame.
+  Module x of row y is bit (x & 63) of word y * words + (x >> 6). Unlike
+   bitmap.h a set bit is black, which is how a decoder reads the modules.*/
+typedef struct QRCodeGrid{
+	int      version;
+	int      size;        //每边的模块数，0表示没有三个center，没有取样
+	int      words;       //每行的64位字数
+	int      orientation; //二维码上边在帧中顺时针转过的90度数，0为正放
+	int      errors;      //三个finder、分隔符和定位图形中取样错误的模块数
+	uint64_t *bits;
+} QRCodeGrid;
+
+//第y行第x个模块，1为黑色
+#define QR_GRID_MODULE(grid, x, y) ((int)((grid)->bits[(size_t)(y) * (grid)->words + ((x) >> 6)] >> ((x) & 63)) & 1)
+
+//列方向扫描的实现方式
+enum{
+	QR_VSCAN_ROWMAJOR = 0, //按行遍历图像，每列保存自己的状态
+	QR_VSCAN_STRIDED,      //逐列遍历图像
+	QR_VSCAN_TRANSPOSE,    //转置后按行扫描
+	QR_VSCAN_TARGETED,     //只扫描x方向cluster附近的列
+};
+
+//二值化的实现方式
+enum{
+	QR_THRESHOLD_FUSED = 0, //灰度化和自适应阈值合并为一遍
+	QR_THRESHOLD_OPENCV,    //cvtColor + adaptiveThreshold
+};
+
+//定位参数，用QR_GetDefaultConfig初始化
+typedef struct QRLocatorConfig{
+	int vscan;          //QR_VSCAN_xxx
+	int min_module_px;  //需要找到的最小模块宽度，大于1时行方向隔行扫描
+	int max_module_px;  //可能出现的最大模块宽度，0表示未知
+	int pyramid;        //金字塔层数，-1根据图像尺寸和模块宽度自动选择
+	int threshold;      //QR_THRESHOLD_xxx
+	int binary_out;     //为1时ProcessImage输出每像素1字节的binary
+	int morph_close;    //为1时二值化后做闭运算消除噪点
+	int min_run_px;     //短于这个长度的游程并入两侧，可以代替闭运算，0表示不合并
+	int threads;        //扫描使用的线程数，包括调用者，0和1表示单线程
+	int max_centers;    //每帧最多保留的finder center数，0表示不限制
+	int rectify;        //为1时按finder位置把每个二维码矫正成正方形输出
+	int grid;           //为1时在每个二维码的模块中心取样，输出位矩阵，见Grids()
+} QRLocatorConfig;
+
+extern void QR_GetDefaultConfig(QRLocatorConfig *config);
+
+/*Reads the next rows of a streamed image, each row width * channels bytes,
+   into dst with step bytes from one row to the next.
+  Return: 0 on success.*/
+typedef int (*QRStripReader)(void *arg, unsigned char *dst, int step, int rows);
+
+//分段处理时每找到一个finder center调用一次
+typedef void (*QRCenterFunc)(void *arg, const QRFinderCenter *center);
+
+/*A binary image being scanned.
+  With bits set it is a 1 bit per pixel bitmap of words 64-bit words per row
+   (see bitmap.h), otherwise bytes holds one byte per pixel, width bytes per
+   row.*/
+typedef struct QRBinaryImage{
+	const unsigned char *bytes;
+	const uint64_t      *bits;
+	int                  words;
+	int                  width;
+	int                  height;
+} QRBinaryImage;
+
+//列方向定向扫描的窗口，像素坐标，[x0, x1) * [y0, y1)
+typedef struct QRScanWindow{
+	int x0;
+	int x1;
+	int y0;
+	int y1;
+} QRScanWindow;
+
+/*Finder lines grouped into clusters while they arrive in scan order.
+  Every line starts a chain and is appended to each open chain that it
+   continues, judged by the last line of the chain; a chain is closed once a
+   line is more than its threshold past that last line, and closed chains
+   become clusters in the order they were started.
+  Chains that end in the same line grow the same way from then on, so they
+   are merged in a union-find forest over the lines: the root of a line is
+   the last line of the chains through it, and the offsets on the way give
+   the size of the chain started there.
+  The last lines of the open chains are indexed by the cell of their
+   position along the line direction, so a new line is only compared with
+   the chains ending in the cells its threshold can reach.
+  lines keeps every line that was added, there is no limit on their number.*/
+typedef struct QRClusterBuilder{
+	int _v;
+	Mat lines;          //QRFinderLine数组
+	int nlines;
+	int fixed;          //最后一条线的固定坐标，线按它排序
+	int maxThresh;      //所有线中最大的阈值
+	Mat links;          //每条线的QRLineLink
+	int head;           //下一条要处理的链的起点
+	Mat cells;          //每个格子中打开的链的最后一条线，-1为空
+	int ncells;
+	Mat members;        //cluster成员的下标，结束时换成指针
+	int nmembers;
+	Mat spans;          //每个cluster在members中的起点和个数
+	int nclusters;
+	Mat grouped;        //按cluster顺序复制的成员
+	Mat clusters;       //QRFinderCluster数组
+} QRClusterBuilder;
+
+/*One band of rows or columns [start, end) scanned by a single task.
+  The finder lines of a band are kept in scan order, so joining the bands in
+   order gives the lines of one serial scan.
+  When a pass runs as a single band the lines go straight to feed instead.*/
+typedef struct QRScanBand{
+	int start;
+	int end;
+	Mat lines;          //QRFinderLine数组
+	int nlines;
+	QRClusterBuilder *feed;
+	Mat hits;           //按行遍历列时的中间结果
+	int nhits;
+	Mat edges;          //跳变位置
+	int scannedRows;
+	int scannedPixels;
+} QRScanBand;
+
+//当前在各带上执行的扫描或二值化任务
+typedef struct QRScanJob{
+	int                  type;   //扫描方式
+	const QRBinaryImage *img;
+	const unsigned char *trans;  //转置后的图像
+	unsigned char       *mark;   //隔行扫描时的行标记
+	int                  step;   //隔行扫描的步长
+	int                  nwin;   //定向扫描的窗口数
+
+	//按行分带二值化时的输入输出，src缩小levels层得到dst，或者转成灰度dst
+	Mat                 *src;
+	Mat                 *dst;
+	int                  levels;
+	uint64_t            *bits;
+	uint64_t            *tmp;    //闭运算中膨胀的结果
+	int                  words;
+} QRScanJob;
+
+/*Locator context.
+  Owns every buffer used while locating a code in one frame, so independent
+   instances can run on different threads at the same time.*/
+class QRLocator{
+public:
+	QRLocator();
+	~QRLocator();
+
+	/*Locate a code in one frame.
+	  binary and qrimg are views into this locator's workspace: they stay valid
+	   until the next call, clone them to keep them longer.
+	  The fused threshold works on a bitmap, binary is then only filled in when
+	   binary_out is set in the config and left empty otherwise.
+	  With several codes in the frame qrimg is the first of them, see Codes().
+	  With rectify set in the config each code found from three centers is
+	   warped upright to QR_CONFIG_RECTIFY_MODULE pixels per module instead,
+	   so its size only depends on the version.
+	  With grid set each code is also sampled into a bit matrix, see Grids().
+	  Return: 0 if a QR square was cropped, otherwise -1.*/
+	int ProcessImage(Mat &raw, Mat &binary, Mat &qrimg);
 
+	/*ProcessImage split into its three stages, so consecutive frames can be
+	   pipelined on different locators (see pipeline.h).
+	  The stages must be called in this order for each frame; raw must stay
+	   unchanged until FinishFrame, which returns what ProcessImage does.*/
+	int  BinarizeFrame(Mat &raw, Mat &binary);
+	void ScanFrame(void);
+	int  FinishFrame(Mat &raw, Mat &qrimg);
 
+	//只在已经二值化的图像上寻找finder center，返回center个数
+	int LocateBinary(Mat &binary);
+
+	//分段读入图像并寻找finder center，内存只和段的高度有关
+	int LocateStrips(QRStripReader reader, void *arg, int width, int height, int channels,
+	                 int strip, QRCenterFunc emit, void *emitArg);
+
+	void SetConfig(const QRLocatorConfig &config) { m_Config = config; }
+	const QRLocatorConfig& GetConfig(void) const { return m_Config; }
+
+	/*Binarize and scan the bands on a pool owned by the caller instead of
+	   creating one from config.threads.
+	  The pool must outlive the locator. ProcessImage may be called from a
+	   task running on the pool, the bands are then handed out as nested
+	   tasks (see threadpool.h); otherwise the pool must not be running tasks
+	   of its own at that time.*/
+	void SetThreadPool(QRThreadPool *pool);
+
+	//工作区重新分配的次数，帧尺寸不超过历史最大值时不再增长
+	int AllocCount(void) const { return m_nAllocs; }
+
+	//最近一帧缩小的层数，binary是缩小后的图像
+	int PyramidLevels(void) const { return m_nLevels; }
+
+	//最近一帧行方向实际扫描的行数
+	int ScannedRows(void) const { return m_nScannedRows; }
+
+	//最近一帧列方向实际扫描的像素数
+	int ScannedPixels(void) const { return m_nScannedPixels; }
+
+	//最近一帧两个方向的finder line和cluster数
+	int LineCount(void) const { return m_XLineSize + m_YLineSize; }
+	int ClusterCount(void) const { return m_nXClusters + m_nYClusters; }
+
+	int CenterCount(void) const { return m_nCenters; }
+	const QRFinderCenter* Centers(void) const { return m_Centers; }
+
+	//超过max_centers而丢弃的center总数，从创建时开始累计
+	int DroppedCenters(void) const { return m_nDroppedCenters; }
+
+	//最近一帧找到的二维码，按三个center的几何吻合程度排序
+	int CodeCount(void) const { return m_nCodes; }
+	const QRCodeRegion* Codes(void) const { return m_Codes; }
+
+	//rectify或grid时每个二维码的变换，和Codes()一一对应
+	const QRCodeTransform* Transforms(void) const { return m_Transforms; }
+
+	/*The module grid of each code, one for every entry of Codes(), or NULL
+	   when grid is not set in the config.
+	  The grids are sampled from the binary frame, so a decoder can read them
+	   without going back to the image.*/
+	const QRCodeGrid* Grids(void) const { return m_Grids; }
+
+	//第index个二维码的裁剪结果，和qrimg一样指向工作区
+	Mat CodeImage(int index) const;
+
+	/*Copy the centers and codes of the last frame into buf, which is only
+	   reallocated when it is too small, so they outlive the next frame.*/
+	void SaveCodes(Mat &buf, QRFinderCenter **centers, int *ncenters, QRCodeRegion **codes, int *ncodes) const;
+
+	//把最近一帧的grid和它们的位复制到buf，没有grid时ngrids为0
+	void SaveGrids(Mat &buf, QRCodeGrid **grids, int *ngrids) const;
+
+private:
+	//不允许拷贝
+	QRLocator(const QRLocator &);
+	QRLocator& operator=(const QRLocator &);
+
+	void* _growBuffer(Mat &buf, size_t used, size_t need);
+	QRFinderLine* _growLines(Mat &buf, int used, int need);
+	QRFinderLine* _pushLine(QRScanBand *band);
+	void _clusterBegin(QRClusterBuilder *b, int _v);
+	void _linkLine(QRClusterBuilder *b, int k, int cell);
+	void _clusterAdd(QRClusterBuilder *b, const QRFinderLine *line);
+	void _resolveChains(QRClusterBuilder *b, int final);
+	int  _clusterEnd(QRClusterBuilder *b, QRFinderLine **lines, int *nlines, QRFinderCluster **clusters);
+	void _feedBand(QRScanBand *band);
+	void _joinBands(int nbands, QRClusterBuilder *b);
+	void _scanRuns(QRScanBand *band, int *edges, int nedges, int black, int fixed, int _v);
+	void _scanColumnsStrided(QRScanBand *band, const QRBinaryImage *img);
+	void _scanColumnsTransposed(QRScanBand *band, const unsigned char *trans, int height);
+	const unsigned char* _transposeImage(const QRBinaryImage *img);
+	int  _buildScanWindows(int width, int height);
+	void _scanColumnsTargeted(QRScanBand *band, const QRBinaryImage *img, int nwin);
+	void _resetColumns(QRScanBand *band, int width);
+	void _scanColumnRows(QRScanBand *band, const QRBinaryImage *img, int ybase, int y0, int y1);
+	void _settleColumnHits(QRScanBand *band, int width, int y, int final);
+	void _scanColumnsRowMajor(QRScanBand *band, const QRBinaryImage *img);
+	int  _scanRow(QRScanBand *band, const QRBinaryImage *img, int y);
+	void _scanBand(QRScanBand *band);
+	static void _runBand(void *arg, int index, int worker);
+	int  _splitBands(int n, int align, int maxEdges, QRClusterBuilder *feed);
+	void _preparePool(void);
+	void _addStripLines(QRScanBand *rows, QRScanBand *cols, int y0);
+	void _dropStripLines(int limit);
+	void _clusterStripLines(void);
+	void _scanImage(const QRBinaryImage *img, int minModule);
+	void _findCenters(void);
+	void _groupCenters(int width, int height);
+	void _sampleGrids(void);
+	int  _locate(const QRBinaryImage *img);
+	int  _findQRSquare(Mat &raw, Mat &qrimg);
+	void _binarize(Mat &src, Mat &gray, Mat &byteBuf, Mat &bitBuf, QRBinaryImage *img);
+	void _outputBinary(const QRBinaryImage *img, Mat &binary);
+	void _refineCenters(Mat &raw, int scale);
+	Mat  _reserveMat(Mat &buf, int rows, int cols, int type);
+
+	QRLocatorConfig m_Config;
+
+	//当前帧二值化的结果和缩小的层数，在各阶段之间传递
+	QRBinaryImage m_Frame;
+	int m_nLevels;
+
+	//扫描时逐条加入的finder line和分组结果
+	QRClusterBuilder m_XBuilder;
+	QRClusterBuilder m_YBuilder;
+
+	//从图片中寻找finder line时使用，指向builder中的数组
+	QRFinderLine *m_XLines;
+	int m_XLineSize;
+	QRFinderLine *m_YLines;
+	int m_YLineSize;
+	QRFinderCluster *m_XClusters;
+	int m_nXClusters;
+	QRFinderCluster *m_YClusters;
+	int m_nYClusters;
+
+	//列方向定向扫描使用
+	QRScanWindow *m_Windows;
+	int m_nScannedPixels;
+	int m_nScannedRows;
+
+	//分带扫描使用，线程池在threads大于1时才创建，也可以共用调用者的
+	QRScanBand m_Bands[QR_CONFIG_MAX_SCAN_BANDS];
+	QRScanJob m_Job;
+	QRThreadPool *m_Pool;
+	int m_OwnPool;
+
+	//分段处理时保留的线
+	Mat m_StripXBuf;
+	int m_nStripX;
+	Mat m_StripYBuf;
+	int m_nStripY;
+	Mat m_StripTmpBuf;  //合并列方向的线时的临时数组，和m_StripYBuf交换
+	QRScanBand m_StripRows;  //行方向每段重新扫描
+	QRScanBand m_StripCols;  //列方向的范围和未确定的hits跨段保留，不用m_Bands，二值化分带时会改写它们
+
+	//给finder center使用，指向m_CenterBuf，数量没有上限
+	QRFinderCenter *m_Centers;
+	int m_nCenters;
+	int m_nDroppedCenters;
+
+	//每个二维码的范围、变换和它在m_CropBuf中的偏移
+	QRCodeRegion *m_Codes;
+	QRCodeTransform *m_Transforms;
+	size_t *m_CropOffsets;
+	int m_nCodes;
+
+	//每个二维码的位矩阵，指向m_GridBuf
+	QRCodeGrid *m_Grids;
+
+	//工作区，按见过的最大帧尺寸保留
+	Mat m_GrayBuf;
+	Mat m_BinaryBuf;
+	Mat m_CropBuf;
+	Mat m_ColStateBuf;
+	Mat m_TransBuf;
+	Mat m_RowMarkBuf;
+	Mat m_SmallBuf;
+	Mat m_WinGrayBuf;
+	Mat m_WinBinaryBuf;
+	Mat m_SumBuf;
+	Mat m_BitBuf;
+	Mat m_WinBitBuf;
+	Mat m_BitTmpBuf;
+	Mat m_UnpackBuf;
+	Mat m_StripBuf;
+	Mat m_WindowBuf;
+	Mat m_CrossBuf;
+	Mat m_GroupBuf;
+	Mat m_CodeBuf;
+	Mat m_CenterBuf;
+	Mat m_CoarseBuf;
+	Mat m_WarpBuf;
+	Mat m_GridBuf;
+	Mat m_Gray;
+	Mat m_Elem;
+	int m_nAllocs;
+};
+
+//C风格句柄接口，每个句柄对应一个独立的QRLocator
+typedef struct QRLocatorHandle_ *QR_LOCATOR;
+
+extern QR_LOCATOR QR_CreateLocator(void);
+extern void QR_DestroyLocator(QR_LOCATOR locator);
+extern int QR_Locate(QR_LOCATOR locator, Mat &raw, Mat &binary, Mat &qrimg);
+extern int QR_SetLocatorConfig(QR_LOCATOR locator, const QRLocatorConfig *config);
+extern int QR_GetAllocCount(QR_LOCATOR locator);
+extern int QR_GetDroppedCenters(QR_LOCATOR locator);
+
+//QR_Locate找到的二维码个数和第index个的裁剪结果
+extern int QR_GetCodeCount(QR_LOCATOR locator);
+extern int QR_GetCodeImage(QR_LOCATOR locator, int index, Mat &qrimg);
+
+//第index个二维码的位矩阵，指向locator的工作区，没有取样时返回-1
+extern int QR_GetCodeGrid(QR_LOCATOR locator, int index, QRCodeGrid *grid);
+
+//使用默认实例，不可重入
+extern void QR_ProcessImage(Mat &raw, Mat &binary, Mat &qrimg);
+
+#endif
@@ -0,0 +1,763 @@
+#include <opencv2/core/core.hpp>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace cv;
+
+#include "payload.h"
+#include "bitmap.h"
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+//版本40的边长和码字总数
+#define QR_MAX_SIZE      177
+#define QR_MAX_CODEWORDS 3706
+
+//每块最多的纠错码字数
+#define QR_MAX_BLOCK_ECC 30
+
+//GF(256)的本原多项式x^8 + x^4 + x^3 + x^2 + 1
+#define QR_GF_POLY 0x11D
+
+//格式信息和版本信息的BCH码最多能纠正的位数
+#define QR_MAX_INFO_ERRORS 3
+
+//每块的纠错码字数和块数，按QR_ECC_xxx和版本排列
+static const signed char g_BlockEcc[4][41] = {
+	{-1,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+	{-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28},
+	{-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30, 28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+	{-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28, 30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+};
+
+static const signed char g_BlockCount[4][41] = {
+	{-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8, 8, 9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},
+	{-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5, 5, 8, 9, 9, 10, 10, 11, 13, 14, 16, 17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49},
+	{-1, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8, 8, 10, 12, 16, 12, 17, 16, 18, 21, 20, 23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68},
+	{-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25, 25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81},
+};
+
+//格式信息中的两位纠错等级
+static const int g_FormatLevel[4] = {QR_ECC_M, QR_ECC_L, QR_ECC_H, QR_ECC_Q};
+
+static const char g_Alnum[46] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+//GF(256)的指数和对数表，指数表重复一遍，乘法不用取模
+static unsigned char g_Exp[512];
+static unsigned char g_Log[256];
+static pthread_once_t g_GaloisOnce = PTHREAD_ONCE_INIT;
+
+static void _initGalois(void)
+{
+	int x;
+	int i;
+
+	x = 1;
+	for (i = 0; i < 255; ++i){
+		g_Exp[i] = (unsigned char)x;
+		g_Exp[i + 255] = (unsigned char)x;
+		g_Log[x] = (unsigned char)i;
+		x <<= 1;
+		if (x & 0x100){
+			x ^= QR_GF_POLY;
+		}
+	}
+	g_Exp[510] = g_Exp[0];
+	g_Exp[511] = g_Exp[1];
+}
+
+static unsigned char _gfMul(unsigned char a, unsigned char b)
+{
+	return (0 == a || 0 == b) ? 0 : g_Exp[g_Log[a] + g_Log[b]];
+}
+
+//b不能为0
+static unsigned char _gfDiv(unsigned char a, unsigned char b)
+{
+	return (0 == a) ? 0 : g_Exp[g_Log[a] + 255 - g_Log[b]];
+}
+
+//多项式在x处的值，系数从低次到高次
+static unsigned char _polyEval(const unsigned char *poly, int n, unsigned char x)
+{
+	unsigned char y;
+	int i;
+
+	y = 0;
+	for (i = n - 1; i >= 0; --i){
+		y = _gfMul(y, x) ^ poly[i];
+	}
+
+	return y;
+}
+
+/*Correct a block of n codewords, the last ecc of them check codewords,
+   in place.
+  The syndromes give the error locator through Berlekamp-Massey, its roots
+   are found by trying every position and the error values come from
+   Forney's formula. With the generator roots starting at alpha^0, an error
+   e at the codeword of degree d adds e * X^i to syndrome i, X = alpha^d.
+  Return: The number of codewords corrected, or -1 if the block has more
+   errors than the check codewords can correct.*/
+static int _correctBlock(unsigned char *block, int n, int ecc)
+{
+	unsigned char syn[QR_MAX_BLOCK_ECC];
+	unsigned char lambda[QR_MAX_BLOCK_ECC + 1];
+	unsigned char prev[QR_MAX_BLOCK_ECC + 1];
+	unsigned char last[QR_MAX_BLOCK_ECC + 1];
+	unsigned char omega[QR_MAX_BLOCK_ECC];
+	unsigned char deriv[QR_MAX_BLOCK_ECC];
+	unsigned char delta;
+	unsigned char scale;
+	unsigned char xinv;
+	unsigned char s;
+	int positions[QR_MAX_BLOCK_ECC / 2];
+	int nerrors;
+	int errors;
+	int shift;
+	int i;
+	int j;
+	int k;
+
+	//按Horner法则求r(alpha^i)，各个i互不依赖，放在内层
+	memset(syn, 0, sizeof(syn));
+	for (k = 0; k < n; ++k){
+		for (i = 0; i < ecc; ++i){
+			syn[i] = ((0 == syn[i]) ? 0 : g_Exp[g_Log[syn[i]] + i]) ^ block[k];
+		}
+	}
+	errors = 0;
+	for (i = 0; i < ecc; ++i){
+		errors |= syn[i];
+	}
+	if (0 == errors){
+		return 0;
+	}
+
+	//Berlekamp-Massey，lambda[0]为1
+	memset(lambda, 0, sizeof(lambda));
+	memset(prev, 0, sizeof(prev));
+	lambda[0] = 1;
+	prev[0] = 1;
+	nerrors = 0;
+	shift = 1;
+	scale = 1;
+	for (i = 0; i < ecc; ++i){
+		delta = syn[i];
+		for (j = 1; j <= nerrors; ++j){
+			delta ^= _gfMul(lambda[j], syn[i - j]);
+		}
+		if (0 == delta){
+			shift += 1;
+			continue;
+		}
+
+		memcpy(last, lambda, sizeof(lambda));
+		for (j = 0; j + shift <= ecc; ++j){
+			lambda[j + shift] ^= _gfMul(_gfDiv(delta, scale), prev[j]);
+		}
+		if (2 * nerrors <= i){
+			nerrors = i + 1 - nerrors;
+			memcpy(prev, last, sizeof(prev));
+			scale = delta;
+			shift = 1;
+		} else {
+			shift += 1;
+		}
+	}
+	if (2 * nerrors > ecc){
+		return -1;
+	}
+
+	//lambda的根是出错位置的倒数，只在块内找
+	errors = 0;
+	for (k = 0; k < n && errors <= nerrors; ++k){
+		if (0 == _polyEval(lambda, nerrors + 1, g_Exp[(255 - (n - 1 - k)) % 255])){
+			if (errors == nerrors){
+				return -1;
+			}
+			positions[errors++] = k;
+		}
+	}
+	if (errors != nerrors){
+		return -1;
+	}
+
+	//omega = syn * lambda mod x^ecc，deriv是lambda的形式导数
+	for (i = 0; i < ecc; ++i){
+		omega[i] = 0;
+		for (j = 0; j <= MIN(i, nerrors); ++j){
+			omega[i] ^= _gfMul(syn[i - j], lambda[j]);
+		}
+	}
+	for (j = 0; j < nerrors; ++j){
+		deriv[j] = (j & 1) ? 0 : lambda[j + 1];
+	}
+
+	for (i = 0; i < nerrors; ++i){
+		k = positions[i];
+		xinv = g_Exp[(255 - (n - 1 - k)) % 255];
+		s = _polyEval(deriv, nerrors, xinv);
+		if (0 == s){
+			return -1;
+		}
+		block[k] ^= _gfMul(g_Exp[n - 1 - k], _gfDiv(_polyEval(omega, ecc, xinv), s));
+	}
+
+	return nerrors;
+}
+
+//功能图形占用的模块，每行QR_BITMAP_WORDS(size)个字
+static void _markRect(uint64_t *func, int words, int x0, int y0, int width, int height)
+{
+	int x;
+	int y;
+
+	for (y = y0; y < y0 + height; ++y){
+		for (x = x0; x < x0 + width; ++x){
+			func[y * words + (x >> 6)] |= (uint64_t)1 << (x & 63);
+		}
+	}
+}
+
+//校正图形中心的坐标，从6开始等距排列，返回个数
+static int _alignmentPositions(int version, int *pos)
+{
+	int count;
+	int step;
+	int i;
+
+	if (1 == version){
+		return 0;
+	}
+
+	count = version / 7 + 2;
+	step = (version * 8 + count * 3 + 5) / (count * 4 - 4) * 2;
+	pos[0] = 6;
+	for (i = count - 1; i >= 1; --i){
+		pos[i] = 4 * version + 10 - (count - 1 - i) * step;
+	}
+
+	return count;
+}
+
+/*Mark the function patterns of a version: the finders with their
+   separators and the format information, the timing patterns, the
+   alignment patterns and from version 7 on the version information.
+  Return: The number of modules left for data and check codewords.*/
+static int _markFunctions(int version, uint64_t *func, int words)
+{
+	int pos[7];
+	int size;
+	int count;
+	int i;
+	int j;
+	int y;
+	int x;
+	int n;
+
+	size = 4 * version + 17;
+	memset(func, 0, sizeof(uint64_t) * words * size);
+	_markRect(func, words, 0, 0, 9, 9);
+	_markRect(func, words, size - 8, 0, 8, 9);
+	_markRect(func, words, 0, size - 8, 9, 8);
+	_markRect(func, words, 6, 0, 1, size);
+	_markRect(func, words, 0, 6, size, 1);
+
+	count = _alignmentPositions(version, pos);
+	for (i = 0; i < count; ++i){
+		for (j = 0; j < count; ++j){
+			//和finder重叠的三个角上没有
+			if ((0 == i && 0 == j) || (0 == i && count - 1 == j) || (count - 1 == i && 0 == j)){
+				continue;
+			}
+			_markRect(func, words, pos[i] - 2, pos[j] - 2, 5, 5);
+		}
+	}
+
+	if (version >= 7){
+		_markRect(func, words, size - 11, 0, 3, 6);
+		_markRect(func, words, 0, size - 11, 6, 3);
+	}
+
+	n = 0;
+	for (y = 0; y < size; ++y){
+		for (x = 0; x < size; ++x){
+			n += !((func[y * words + (x >> 6)] >> (x & 63)) & 1);
+		}
+	}
+
+	return n;
+}
+
+//第y行第x个模块，mirror时按转置读
+static int _module(const QRCodeGrid *grid, int x, int y, int mirror)
+{
+	return mirror ? QR_GRID_MODULE(grid, y, x) : QR_GRID_MODULE(grid, x, y);
+}
+
+/*The mask over 12 x 12 modules, after which every mask repeats, 1 where a
+   module is inverted.*/
+static void _maskTable(int mask, unsigned char *table)
+{
+	int x;
+	int y;
+	int v;
+
+	for (y = 0; y < 12; ++y){
+		for (x = 0; x < 12; ++x){
+			switch (mask){
+			case 0: v = (x + y) % 2; break;
+			case 1: v = y % 2; break;
+			case 2: v = x % 3; break;
+			case 3: v = (x + y) % 3; break;
+			case 4: v = (x / 3 + y / 2) % 2; break;
+			case 5: v = x * y % 2 + x * y % 3; break;
+			case 6: v = (x * y % 2 + x * y % 3) % 2; break;
+			default: v = ((x + y) % 2 + x * y % 3) % 2; break;
+			}
+			table[y * 12 + x] = (0 == v);
+		}
+	}
+}
+
+static int _popCount(unsigned int v)
+{
+	return __builtin_popcount(v);
+}
+
+/*Read the format information from both copies and take the valid format
+   closest to either of them.
+  Return: The 5 data bits, or -1 if neither copy is within
+   QR_MAX_INFO_ERRORS bits of a valid format.*/
+static int _readFormat(const QRCodeGrid *grid, int mirror)
+{
+	unsigned int copy[2];
+	unsigned int code;
+	unsigned int rem;
+	int size;
+	int best;
+	int dist;
+	int data;
+	int i;
+	int k;
+
+	size = grid->size;
+	copy[0] = 0;
+	copy[1] = 0;
+	for (i = 0; i < 6; ++i){
+		copy[0] |= _module(grid, 8, i, mirror) << i;
+	}
+	copy[0] |= _module(grid, 8, 7, mirror) << 6;
+	copy[0] |= _module(grid, 8, 8, mirror) << 7;
+	copy[0] |= _module(grid, 7, 8, mirror) << 8;
+	for (i = 9; i < 15; ++i){
+		copy[0] |= _module(grid, 14 - i, 8, mirror) << i;
+	}
+	for (i = 0; i < 8; ++i){
+		copy[1] |= _module(grid, size - 1 - i, 8, mirror) << i;
+	}
+	for (i = 8; i < 15; ++i){
+		copy[1] |= _module(grid, 8, size - 15 + i, mirror) << i;
+	}
+
+	best = QR_MAX_INFO_ERRORS + 1;
+	data = -1;
+	for (i = 0; i < 32; ++i){
+		rem = i;
+		for (k = 0; k < 10; ++k){
+			rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+		}
+		code = ((i << 10) | rem) ^ 0x5412;
+		for (k = 0; k < 2; ++k){
+			dist = _popCount(code ^ copy[k]);
+			if (dist < best){
+				best = dist;
+				data = i;
+			}
+		}
+	}
+
+	return data;
+}
+
+/*Read the version information of a code of version 7 or more.
+  Return: The version closest to either copy, or 0 if neither is within
+   QR_MAX_INFO_ERRORS bits of a valid one.*/
+static int _readVersionInfo(const QRCodeGrid *grid, int mirror)
+{
+	unsigned int copy[2];
+	unsigned int code;
+	unsigned int rem;
+	int best;
+	int dist;
+	int version;
+	int i;
+	int k;
+
+	copy[0] = 0;
+	copy[1] = 0;
+	for (i = 0; i < 18; ++i){
+		copy[0] |= _module(grid, grid->size - 11 + i % 3, i / 3, mirror) << i;
+		copy[1] |= _module(grid, i / 3, grid->size - 11 + i % 3, mirror) << i;
+	}
+
+	best = QR_MAX_INFO_ERRORS + 1;
+	version = 0;
+	for (i = 7; i <= 40; ++i){
+		rem = i;
+		for (k = 0; k < 12; ++k){
+			rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+		}
+		code = (i << 12) | rem;
+		for (k = 0; k < 2; ++k){
+			dist = _popCount(code ^ copy[k]);
+			if (dist < best){
+				best = dist;
+				version = i;
+			}
+		}
+	}
+
+	return version;
+}
+
+/*Read the codewords in the zigzag order: two columns at a time from the
+   right, up and down in turn, skipping the timing column and every
+   function module, unmasking as they are read. The remainder bits after
+   the last whole codeword are left out.*/
+static void _readCodewords(const QRCodeGrid *grid, int mirror, int mask, const uint64_t *func, int words, unsigned char *codewords, int ncodewords)
+{
+	unsigned char table[12 * 12];
+	int right;
+	int vert;
+	int bit;
+	int x;
+	int y;
+	int j;
+	int n;
+
+	_maskTable(mask, table);
+	memset(codewords, 0, ncodewords);
+	n = 0;
+	for (right = grid->size - 1; right >= 1; right -= 2){
+		if (6 == right){
+			right = 5;
+		}
+		for (vert = 0; vert < grid->size; ++vert){
+			for (j = 0; j < 2; ++j){
+				x = right - j;
+				//从最右边两列开始向上
+				y = (0 == ((right + 1) & 2)) ? grid->size - 1 - vert : vert;
+				if ((func[y * words + (x >> 6)] >> (x & 63)) & 1){
+					continue;
+				}
+				if (n >= ncodewords * 8){
+					return;
+				}
+				bit = _module(grid, x, y, mirror) ^ table[(y % 12) * 12 + x % 12];
+				codewords[n >> 3] |= bit << (7 - (n & 7));
+				n += 1;
+			}
+		}
+	}
+
+	return;
+}
+
+//按位读出数据码字的游标
+typedef struct QRBitReader{
+	const unsigned char *data;
+	int nbits;
+	int pos;
+} QRBitReader;
+
+//高位在前读出n位，不够时返回-1
+static int _readBits(QRBitReader *r, int n)
+{
+	int v;
+	int i;
+
+	if (r->pos + n > r->nbits){
+		return -1;
+	}
+
+	v = 0;
+	for (i = 0; i < n; ++i, ++r->pos){
+		v = (v << 1) | ((r->data[r->pos >> 3] >> (7 - (r->pos & 7))) & 1);
+	}
+
+	return v;
+}
+
+static int _putByte(QRPayload *payload, int c)
+{
+	if (payload->length >= QR_PAYLOAD_MAX){
+		return -1;
+	}
+	payload->data[payload->length++] = (unsigned char)c;
+
+	return 0;
+}
+
+//写出n位十进制数，不足n位时前面补0
+static int _putDigits(QRPayload *payload, int v, int n)
+{
+	char digits[3];
+	int i;
+
+	for (i = n - 1; i >= 0; --i){
+		digits[i] = (char)('0' + v % 10);
+		v /= 10;
+	}
+	for (i = 0; i < n; ++i){
+		if (0 != _putByte(payload, digits[i])){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*Join the segments of the data codewords into payload->data.
+  Return: 0 on success, or -1 if a segment runs past the data or holds an
+   invalid value.*/
+static int _readSegments(const unsigned char *data, int ndata, int version, QRPayload *payload)
+{
+	QRBitReader r;
+	int group;
+	int mode;
+	int count;
+	int v;
+	int i;
+
+	r.data = data;
+	r.nbits = ndata * 8;
+	r.pos = 0;
+
+	//字符数的位数分版本1-9、10-26、27-40三档
+	group = (version <= 9) ? 0 : (version <= 26) ? 1 : 2;
+	for (;;){
+		//不足4位时终止符可以省略
+		mode = _readBits(&r, 4);
+		if (mode <= 0){
+			break;
+		}
+
+		switch (mode){
+		case 1: //数字，3位一组10位
+			count = _readBits(&r, 10 + 2 * group);
+			if (count < 0){
+				return -1;
+			}
+			for (; count >= 3; count -= 3){
+				v = _readBits(&r, 10);
+				if (v < 0 || v > 999 || 0 != _putDigits(payload, v, 3)){
+					return -1;
+				}
+			}
+			if (count > 0){
+				v = _readBits(&r, 3 * count + 1);
+				if (v < 0 || v >= (2 == count ? 100 : 10) || 0 != _putDigits(payload, v, count)){
+					return -1;
+				}
+			}
+			break;
+		case 2: //字母数字，2个一组11位
+			count = _readBits(&r, 9 + 2 * group);
+			if (count < 0){
+				return -1;
+			}
+			for (; count >= 2; count -= 2){
+				v = _readBits(&r, 11);
+				if (v < 0 || v >= 45 * 45 || 0 != _putByte(payload, g_Alnum[v / 45]) || 0 != _putByte(payload, g_Alnum[v % 45])){
+					return -1;
+				}
+			}
+			if (count > 0){
+				v = _readBits(&r, 6);
+				if (v < 0 || v >= 45 || 0 != _putByte(payload, g_Alnum[v])){
+					return -1;
+				}
+			}
+			break;
+		case 4: //8位字节
+			count = _readBits(&r, (0 == group) ? 8 : 16);
+			if (count < 0){
+				return -1;
+			}
+			for (i = 0; i < count; ++i){
+				v = _readBits(&r, 8);
+				if (v < 0 || 0 != _putByte(payload, v)){
+					return -1;
+				}
+			}
+			break;
+		case 8: //汉字，13位还原成Shift JIS
+			count = _readBits(&r, 8 + 2 * group);
+			if (count < 0){
+				return -1;
+			}
+			for (i = 0; i < count; ++i){
+				v = _readBits(&r, 13);
+				if (v < 0){
+					return -1;
+				}
+				v = ((v / 0xC0) << 8) | (v % 0xC0);
+				v += (v < 0x1F00) ? 0x8140 : 0xC140;
+				if (0 != _putByte(payload, v >> 8) || 0 != _putByte(payload, v & 0xFF)){
+					return -1;
+				}
+			}
+			break;
+		case 7: //ECI，指定符是1到3个字节，由开头的位数区分
+			v = _readBits(&r, 8);
+			if (v >= 0 && 0x80 == (v & 0xC0)){
+				i = _readBits(&r, 8);
+				v = (i < 0) ? -1 : (((v & 0x3F) << 8) | i);
+			} else if (v >= 0 && 0xC0 == (v & 0xE0)){
+				i = _readBits(&r, 16);
+				v = (i < 0) ? -1 : (((v & 0x1F) << 16) | i);
+			} else if (v >= 0 && 0 != (v & 0x80)){
+				return -1;
+			}
+			if (v < 0){
+				return -1;
+			}
+			payload->eci = v;
+			break;
+		case 3: //结构链接，序号、总数和校验
+			if (_readBits(&r, 16) < 0){
+				return -1;
+			}
+			break;
+		case 5: //FNC1在第一位，没有参数
+			break;
+		case 9: //FNC1在第二位，应用标识
+			if (_readBits(&r, 8) < 0){
+				return -1;
+			}
+			break;
+		default:
+			return -1;
+		}
+	}
+	payload->data[payload->length] = 0;
+
+	return 0;
+}
+
+/*Decode the grid read as it is or, with mirror, transposed.
+  Return: As QR_DecodePayload.*/
+static int _decodeGrid(const QRCodeGrid *grid, int mirror, QRPayload *payload)
+{
+	uint64_t func[QR_MAX_SIZE * QR_BITMAP_WORDS(QR_MAX_SIZE)];
+	unsigned char codewords[QR_MAX_CODEWORDS];
+	unsigned char blocks[QR_MAX_CODEWORDS];
+	unsigned char *block;
+	int version;
+	int format;
+	int total;
+	int nblocks;
+	int nshort;
+	int shortLen;
+	int ecc;
+	int ndata;
+	int len;
+	int corrected;
+	int words;
+	int i;
+	int j;
+	int k;
+
+	version = (grid->size - 17) / 4;
+	payload->version = version;
+	payload->mirrored = mirror;
+	payload->corrected = 0;
+	payload->eci = -1;
+	payload->length = 0;
+	payload->data[0] = 0;
+
+	format = _readFormat(grid, mirror);
+	if (format < 0){
+		return QR_PAYLOAD_NO_FORMAT;
+	}
+	payload->level = g_FormatLevel[format >> 3];
+	payload->mask = format & 7;
+
+	//版本信息读不出时按grid的尺寸解
+	if (version >= 7){
+		k = _readVersionInfo(grid, mirror);
+		if (0 != k && k != version){
+			return QR_PAYLOAD_BAD_VERSION;
+		}
+	}
+
+	words = QR_BITMAP_WORDS(grid->size);
+	total = _markFunctions(version, func, words) / 8;
+	_readCodewords(grid, mirror, payload->mask, func, words, codewords, total);
+
+	//交织时短块在前，长块多一个数据码字，插在短块数据的末尾之后
+	ecc = g_BlockEcc[payload->level][version];
+	nblocks = g_BlockCount[payload->level][version];
+	nshort = nblocks - total % nblocks;
+	shortLen = total / nblocks;
+	k = 0;
+	for (i = 0; i <= shortLen; ++i){
+		for (j = 0; j < nblocks; ++j){
+			if (i == shortLen - ecc && j < nshort){
+				continue;
+			}
+			block = blocks + j * shortLen + MAX(0, j - nshort);
+			block[(j < nshort && i > shortLen - ecc) ? i - 1 : i] = codewords[k++];
+		}
+	}
+
+	//纠错后把各块的数据码字依次放回codewords
+	ndata = 0;
+	corrected = 0;
+	for (j = 0; j < nblocks; ++j){
+		block = blocks + j * shortLen + MAX(0, j - nshort);
+		len = shortLen + (j >= nshort);
+		k = _correctBlock(block, len, ecc);
+		if (k < 0){
+			return QR_PAYLOAD_UNCORRECTABLE;
+		}
+		corrected += k;
+		memcpy(codewords + ndata, block, len - ecc);
+		ndata += len - ecc;
+	}
+	payload->corrected = corrected;
+
+	if (0 != _readSegments(codewords, ndata, version, payload)){
+		return QR_PAYLOAD_BAD_SEGMENT;
+	}
+
+	return QR_PAYLOAD_OK;
+}
+
+int QR_DecodePayload(const QRCodeGrid *grid, QRPayload *payload)
+{
+	int ret;
+
+	if (NULL == grid || NULL == grid->bits || grid->size < 21 || grid->size > QR_MAX_SIZE || 0 != (grid->size - 17) % 4){
+		return QR_PAYLOAD_NO_GRID;
+	}
+
+	pthread_once(&g_GaloisOnce, _initGalois);
+
+	//镜像的二维码被locator读成了转置
+	ret = _decodeGrid(grid, 0, payload);
+	if (QR_PAYLOAD_OK != ret && QR_PAYLOAD_OK == _decodeGrid(grid, 1, payload)){
+		return QR_PAYLOAD_OK;
+	}
+
+	return ret;
+}
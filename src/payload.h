@@ -0,0 +1,53 @@
+#ifndef _PAYLOAD_H_
+#define _PAYLOAD_H_
+
+#include "locator.h"
+
+//解出内容的最大长度，版本40-L的数字模式
+#define QR_PAYLOAD_MAX 7089
+
+//纠错等级
+enum{
+	QR_ECC_L = 0,
+	QR_ECC_M,
+	QR_ECC_Q,
+	QR_ECC_H,
+};
+
+//QR_DecodePayload的结果
+enum{
+	QR_PAYLOAD_OK = 0,
+	QR_PAYLOAD_NO_GRID = -1,        //grid为空或者尺寸不是合法的版本
+	QR_PAYLOAD_NO_FORMAT = -2,      //两份格式信息都无法识别
+	QR_PAYLOAD_BAD_VERSION = -3,    //版本信息和grid的尺寸不符
+	QR_PAYLOAD_UNCORRECTABLE = -4,  //错误超出了纠错能力
+	QR_PAYLOAD_BAD_SEGMENT = -5,    //数据段的格式错误
+};
+
+typedef struct QRPayload{
+	int version;
+	int level;      //QR_ECC_xxx
+	int mask;
+	int mirrored;   //为1时二维码是镜像的，按grid的转置读出
+	int corrected;  //Reed-Solomon纠正的码字数
+	int eci;        //最后一个ECI段指定的字符集，没有时为-1
+	int length;     //data中的字节数
+	unsigned char data[QR_PAYLOAD_MAX + 1]; //以0结尾，汉字模式输出Shift JIS
+} QRPayload;
+
+/*Decode the content of a code from its sampled module grid (see
+   QRLocator::Grids), without going back to the image.
+  The format information is read from whichever copy is closer to a valid
+   one, the modules are unmasked and read in the zigzag order, the blocks
+   are deinterleaved and corrected with Reed-Solomon, and the numeric,
+   alphanumeric, byte and kanji segments are joined into data. ECI,
+   structured append and FNC1 headers are skipped.
+  When the grid does not read, it is read again transposed, which is how a
+   mirrored code comes out of the locator.
+  Needs no allocation, and the Galois field tables are built once behind
+   pthread_once, so it may run on any thread.
+  Return: QR_PAYLOAD_OK, or one of the QR_PAYLOAD_xxx errors, when payload
+   is only partly filled in.*/
+extern int QR_DecodePayload(const QRCodeGrid *grid, QRPayload *payload);
+
+#endif
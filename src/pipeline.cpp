@@ -0,0 +1,313 @@
+#include <opencv2/core/core.hpp>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace cv;
+
+#include "pipeline.h"
+
+//一帧在流水线中的全部状态
+typedef struct QRFrameSlot{
+	int        frameId;
+	int        status;
+	Mat        raw;
+	Mat        binary;
+	Mat        qrimg;
+	QRLocator *locator;
+} QRFrameSlot;
+
+//有界的先进先出队列
+typedef struct QRFrameQueue{
+	QRFrameSlot   **items;
+	int             capacity;
+	int             head;
+	int             count;
+	int             closed;
+	pthread_mutex_t lock;
+	pthread_cond_t  notEmpty;
+	pthread_cond_t  notFull;
+} QRFrameQueue;
+
+//流水线的各个阶段
+enum{
+	QR_STAGE_BINARIZE = 0,
+	QR_STAGE_SCAN,
+	QR_STAGE_FINISH,
+	QR_STAGE_COUNT
+};
+
+typedef struct QRStage{
+	int           type;
+	QRFrameQueue *in;
+	QRFrameQueue *out;
+	pthread_t     thread;
+	int           started;
+} QRStage;
+
+typedef struct QRPipeline{
+	QRFrameSlot  *slots;
+	int           nslots;
+
+	//free -> 各阶段 -> done -> free
+	QRFrameQueue  queues[QR_STAGE_COUNT + 2];
+	QRStage       stages[QR_STAGE_COUNT];
+	int           inflight;
+} QRPipeline;
+
+#define QR_QUEUE_FREE 0
+#define QR_QUEUE_DONE (QR_STAGE_COUNT + 1)
+
+static int _queueInit(QRFrameQueue *queue, int capacity)
+{
+	queue->items = (QRFrameSlot **)calloc(capacity, sizeof(QRFrameSlot *));
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->count = 0;
+	queue->closed = 0;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->notEmpty, NULL);
+	pthread_cond_init(&queue->notFull, NULL);
+
+	return (NULL == queue->items) ? -1 : 0;
+}
+
+static void _queueDestroy(QRFrameQueue *queue)
+{
+	pthread_cond_destroy(&queue->notFull);
+	pthread_cond_destroy(&queue->notEmpty);
+	pthread_mutex_destroy(&queue->lock);
+	free(queue->items);
+}
+
+static void _queuePush(QRFrameQueue *queue, QRFrameSlot *slot)
+{
+	pthread_mutex_lock(&queue->lock);
+	while (queue->count == queue->capacity){
+		pthread_cond_wait(&queue->notFull, &queue->lock);
+	}
+	queue->items[(queue->head + queue->count) % queue->capacity] = slot;
+	queue->count += 1;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/*Take the oldest slot of the queue.
+  Return: NULL when the queue is empty and either wait is 0 or the queue has
+   been closed.*/
+static QRFrameSlot* _queuePop(QRFrameQueue *queue, int wait)
+{
+	QRFrameSlot *slot;
+
+	pthread_mutex_lock(&queue->lock);
+	while (wait && 0 == queue->count && !queue->closed){
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+	}
+
+	slot = NULL;
+	if (queue->count > 0){
+		slot = queue->items[queue->head];
+		queue->head = (queue->head + 1) % queue->capacity;
+		queue->count -= 1;
+		pthread_cond_signal(&queue->notFull);
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return slot;
+}
+
+//不再有新的帧，等待的线程在队列取空后退出
+static void _queueClose(QRFrameQueue *queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = 1;
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+static void* _stageThread(void *arg)
+{
+	QRStage *stage;
+	QRFrameSlot *slot;
+
+	stage = (QRStage *)arg;
+	for (;;){
+		slot = _queuePop(stage->in, 1);
+		if (NULL == slot){
+			break;
+		}
+
+		switch (stage->type){
+			case QR_STAGE_BINARIZE:
+				slot->locator->BinarizeFrame(slot->raw, slot->binary);
+				break;
+			case QR_STAGE_SCAN:
+				slot->locator->ScanFrame();
+				break;
+			default:
+				slot->status = slot->locator->FinishFrame(slot->raw, slot->qrimg);
+				break;
+		}
+
+		_queuePush(stage->out, slot);
+	}
+
+	//下一个阶段处理完剩下的帧后也退出
+	_queueClose(stage->out);
+
+	return NULL;
+}
+
+QR_PIPELINE QR_CreatePipeline(int slots, const QRLocatorConfig *config)
+{
+	QRLocatorConfig cfg;
+	QRPipeline *pipeline;
+	QRStage *stage;
+	int i;
+
+	if (NULL == config){
+		QR_GetDefaultConfig(&cfg);
+	} else {
+		cfg = *config;
+	}
+
+	pipeline = (QRPipeline *)calloc(1, sizeof(QRPipeline));
+	if (NULL == pipeline){
+		return NULL;
+	}
+
+	pipeline->nslots = (slots > 0) ? slots : QR_CONFIG_PIPELINE_SLOTS;
+	pipeline->slots = new QRFrameSlot[pipeline->nslots];
+
+	//Mat成员使slot不会被清零，建立队列失败时QR_DestroyPipeline要能删除locator
+	for (i = 0; i < pipeline->nslots; ++i){
+		pipeline->slots[i].locator = NULL;
+	}
+	for (i = 0; i < QR_STAGE_COUNT + 2; ++i){
+		if (0 != _queueInit(pipeline->queues + i, pipeline->nslots)){
+			QR_DestroyPipeline((QR_PIPELINE)pipeline);
+			return NULL;
+		}
+	}
+
+	//开始时所有帧都空闲
+	for (i = 0; i < pipeline->nslots; ++i){
+		pipeline->slots[i].locator = new QRLocator();
+		pipeline->slots[i].locator->SetConfig(cfg);
+		_queuePush(pipeline->queues + QR_QUEUE_FREE, pipeline->slots + i);
+	}
+
+	for (i = 0; i < QR_STAGE_COUNT; ++i){
+		stage = pipeline->stages + i;
+		stage->type = i;
+		stage->in = pipeline->queues + i + 1;
+		stage->out = pipeline->queues + i + 2;
+		if (0 != pthread_create(&stage->thread, NULL, _stageThread, stage)){
+			QR_DestroyPipeline((QR_PIPELINE)pipeline);
+			return NULL;
+		}
+		stage->started = 1;
+	}
+
+	return (QR_PIPELINE)pipeline;
+}
+
+void QR_DestroyPipeline(QR_PIPELINE handle)
+{
+	QRPipeline *pipeline;
+	int i;
+
+	pipeline = (QRPipeline *)handle;
+	if (NULL == pipeline){
+		return;
+	}
+
+	//从第一个阶段开始依次关闭，还在流水线中的帧处理完后丢弃
+	if (NULL != pipeline->queues[QR_STAGE_BINARIZE + 1].items){
+		_queueClose(pipeline->queues + QR_STAGE_BINARIZE + 1);
+	}
+	for (i = 0; i < QR_STAGE_COUNT; ++i){
+		if (pipeline->stages[i].started){
+			pthread_join(pipeline->stages[i].thread, NULL);
+		} else if (NULL != pipeline->queues[i + 2].items){
+			_queueClose(pipeline->queues + i + 2);
+		}
+	}
+
+	for (i = 0; i < QR_STAGE_COUNT + 2; ++i){
+		if (NULL != pipeline->queues[i].items){
+			_queueDestroy(pipeline->queues + i);
+		}
+	}
+	for (i = 0; i < pipeline->nslots; ++i){
+		delete pipeline->slots[i].locator;
+	}
+	delete [] pipeline->slots;
+	free(pipeline);
+
+	return;
+}
+
+int QR_PushFrame(QR_PIPELINE handle, Mat &raw, int frameId)
+{
+	QRPipeline *pipeline;
+	QRFrameSlot *slot;
+
+	pipeline = (QRPipeline *)handle;
+	if (NULL == pipeline || raw.empty()){
+		return -1;
+	}
+
+	//空闲的帧只在取走结果时归还，所以这里不能等待
+	slot = _queuePop(pipeline->queues + QR_QUEUE_FREE, 0);
+	if (NULL == slot){
+		return 1;
+	}
+
+	raw.copyTo(slot->raw);
+	slot->frameId = frameId;
+	slot->status = -1;
+	pipeline->inflight += 1;
+	_queuePush(pipeline->queues + QR_STAGE_BINARIZE + 1, slot);
+
+	return 0;
+}
+
+int QR_PopResult(QR_PIPELINE handle, QRPipelineResult *result, int wait)
+{
+	QRPipeline *pipeline;
+	QRFrameSlot *slot;
+
+	pipeline = (QRPipeline *)handle;
+	if (NULL == pipeline || NULL == result){
+		return -1;
+	}
+
+	if (0 == pipeline->inflight){
+		return 0;
+	}
+
+	slot = _queuePop(pipeline->queues + QR_QUEUE_DONE, wait);
+	if (NULL == slot){
+		return 0;
+	}
+
+	result->frameId = slot->frameId;
+	result->status = slot->status;
+	slot->locator->SaveCodes(result->codeBuf, &result->centers, &result->ncenters, &result->codes, &result->ncodes);
+	slot->locator->SaveGrids(result->gridBuf, &result->grids, &result->ngrids);
+	if (0 == slot->status){
+		slot->qrimg.copyTo(result->qrimg);
+	} else {
+		result->qrimg.release();
+	}
+
+	//FinishFrame在slot->raw上画了标记，交换缓冲区不用复制整帧
+	swap(result->frame, slot->raw);
+
+	pipeline->inflight -= 1;
+	_queuePush(pipeline->queues + QR_QUEUE_FREE, slot);
+
+	return 1;
+}
@@ -0,0 +1,56 @@
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include "locator.h"
+
+//流水线中同时处理的帧数，每帧占用一个locator
+#define QR_CONFIG_PIPELINE_SLOTS 4
+
+typedef struct QRPipelineResult{
+	int            frameId;  //QR_PushFrame时给出的编号
+	int            status;   //0找到并裁剪出了二维码，-1没有找到
+	int            ncenters;
+	QRFinderCenter *centers; //指向codeBuf
+	int            ncodes;
+	QRCodeRegion   *codes;   //每个二维码在帧中的范围，指向codeBuf
+	int            ngrids;
+	QRCodeGrid     *grids;   //config.grid为1时每个二维码的位矩阵，指向gridBuf
+	Mat            qrimg;    //裁剪出的第一个二维码，属于结果自己
+	Mat            frame;    //画上了cluster和center的帧，见QR_PopResult
+	Mat            codeBuf;  //centers和codes的存储，属于结果自己，只增不减
+	Mat            gridBuf;  //grids和它们的位，属于结果自己，只增不减
+} QRPipelineResult;
+
+/*Locate codes in a stream of frames with the three stages of
+   ProcessImage running on their own threads: while frame N is clustered
+   and cropped, frame N+1 is scanned and frame N+2 is binarized.
+  Each frame in flight owns one of slots locators, so the stages never
+   share buffers. Frames pass between the stages through bounded queues and
+   a slot is only given back when its result is popped, which bounds the
+   number of frames in flight.
+  Results come out in the order the frames were pushed, tagged with their
+   frame id.
+  Push and pop from one thread only.*/
+typedef struct QRPipelineHandle_ *QR_PIPELINE;
+
+//slots为0时使用QR_CONFIG_PIPELINE_SLOTS，config为NULL时使用默认参数
+extern QR_PIPELINE QR_CreatePipeline(int slots, const QRLocatorConfig *config);
+extern void QR_DestroyPipeline(QR_PIPELINE pipeline);
+
+/*Copy raw into a free slot and start it down the pipeline.
+  Return: 0 if the frame was pushed, 1 if every slot is in flight and a
+   result must be popped first, -1 on bad arguments.*/
+extern int QR_PushFrame(QR_PIPELINE pipeline, Mat &raw, int frameId);
+
+/*Take the result of the oldest frame still in the pipeline.
+  With wait set, blocks until that frame is done.
+  result->frame is swapped with the buffer of the frame's slot, so the
+   buffer it held before goes back to the pipeline, and the next
+   QR_PushFrame that takes this slot copies its frame into it. Any Mat
+   sharing that buffer, such as the frame of an earlier result, changes
+   then; clone it to keep it.
+  Return: 1 if result was filled in, 0 if no result is ready or no frame is
+   in flight, -1 on bad arguments.*/
+extern int QR_PopResult(QR_PIPELINE pipeline, QRPipelineResult *result, int wait);
+
+#endif
@@ -0,0 +1,2081 @@
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+using namespace cv;
+
+#include "locator.h"
+#include "transition.h"
+#include "threshold.h"
+#include "bitmap.h"
+#include "batch.h"
+#include "pipeline.h"
+#include "payload.h"
+#include "decoder.h"
+
+#define BENCH_WIDTH  1920
+#define BENCH_ROWS   1080
+#define BENCH_ROUNDS 20
+
+static double _now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+//生成一幅黑白随机图像，游程长度在1到run之间
+static void _fillRuns(unsigned char *img, int width, int height, int run)
+{
+	int x;
+	int y;
+	int len;
+	unsigned char color;
+
+	for (y = 0; y < height; ++y){
+		color = (rand() & 1) ? 0xFF : 0x00;
+		x = 0;
+		while (x < width){
+			len = 1 + rand() % run;
+			while (len-- > 0 && x < width){
+				img[y * width + x++] = color;
+			}
+			color = ~color;
+		}
+	}
+}
+
+//每种实现每秒处理的行数
+static int _benchTransition(void)
+{
+	unsigned char *img;
+	int *edges;
+	int *expect;
+	int path;
+	int round;
+	int y;
+	int n;
+	int total;
+	int run;
+	double start;
+	double cost;
+
+	img = (unsigned char *)malloc(BENCH_WIDTH * BENCH_ROWS);
+	edges = (int *)malloc(sizeof(int) * BENCH_WIDTH);
+	expect = (int *)malloc(sizeof(int) * BENCH_WIDTH);
+
+	for (run = 4; run <= 64; run *= 4){
+		_fillRuns(img, BENCH_WIDTH, BENCH_ROWS, run);
+		printf("transition: %d x %d, run length 1..%d\n", BENCH_WIDTH, BENCH_ROWS, run);
+
+		for (path = QR_TRANSITION_SCALAR; path < QR_TRANSITION_MAX; ++path){
+			if (0 != QR_SetTransitionPath(path)){
+				printf("  %-8s not supported\n", QR_TransitionPathName(path));
+				continue;
+			}
+
+			//先和标量实现对比结果
+			for (y = 0; y < BENCH_ROWS; ++y){
+				QR_SetTransitionPath(QR_TRANSITION_SCALAR);
+				n = QR_FindTransitions(img + y * BENCH_WIDTH, BENCH_WIDTH, 1, expect);
+				QR_SetTransitionPath(path);
+				if (n != QR_FindTransitions(img + y * BENCH_WIDTH, BENCH_WIDTH, 1, edges) ||
+				    0 != memcmp(expect, edges, sizeof(int) * n)){
+					printf("  %-8s mismatch at row %d\n", QR_TransitionPathName(path), y);
+					return -1;
+				}
+			}
+
+			total = 0;
+			start = _now();
+			for (round = 0; round < BENCH_ROUNDS; ++round){
+				for (y = 0; y < BENCH_ROWS; ++y){
+					total += QR_FindTransitions(img + y * BENCH_WIDTH, BENCH_WIDTH, 1, edges);
+				}
+			}
+			cost = _now() - start;
+
+			printf("  %-8s %10.0f rows/s  (%d edges)\n", QR_TransitionPathName(path),
+			       BENCH_ROUNDS * BENCH_ROWS / cost, total / BENCH_ROUNDS);
+		}
+	}
+
+	QR_SetTransitionPath(QR_TRANSITION_AUTO);
+	printf("auto selects %s\n", QR_TransitionPathName(QR_GetTransitionPath()));
+
+	free(img);
+	free(edges);
+	free(expect);
+
+	return 0;
+}
+
+//在(x, y)处画一个finder，m是模块的像素宽度
+static void _drawFinder(Mat &img, int x, int y, int m)
+{
+	rectangle(img, Rect(x, y, 7 * m, 7 * m), Scalar(0x00), CV_FILLED);
+	rectangle(img, Rect(x + m, y + m, 5 * m, 5 * m), Scalar(0xFF), CV_FILLED);
+	rectangle(img, Rect(x + 2 * m, y + 2 * m, 3 * m, 3 * m), Scalar(0x00), CV_FILLED);
+}
+
+//画一个n*n模块的二维码，三个角上是finder，finder之间是定位图形，其余模块随机
+static void _drawCode(Mat &img, int x, int y, int m, int n)
+{
+	int mx;
+	int my;
+	int i;
+
+	for (my = 0; my < n; ++my){
+		for (mx = 0; mx < n; ++mx){
+			rectangle(img, Rect(x + mx * m, y + my * m, m, m), Scalar((rand() & 1) ? 0xFF : 0x00), CV_FILLED);
+		}
+	}
+
+	//finder外面有一圈白色分隔带
+	rectangle(img, Rect(x, y, 8 * m, 8 * m), Scalar(0xFF), CV_FILLED);
+	rectangle(img, Rect(x + (n - 8) * m, y, 8 * m, 8 * m), Scalar(0xFF), CV_FILLED);
+	rectangle(img, Rect(x, y + (n - 8) * m, 8 * m, 8 * m), Scalar(0xFF), CV_FILLED);
+	_drawFinder(img, x, y, m);
+	_drawFinder(img, x + (n - 7) * m, y, m);
+	_drawFinder(img, x, y + (n - 7) * m, m);
+
+	for (i = 8; i < n - 8; ++i){
+		rectangle(img, Rect(x + i * m, y + 6 * m, m, m), Scalar((i & 1) ? 0xFF : 0x00), CV_FILLED);
+		rectangle(img, Rect(x + 6 * m, y + i * m, m, m), Scalar((i & 1) ? 0xFF : 0x00), CV_FILLED);
+	}
+}
+
+/*Fill the modules of an n*n code, 1 for black: the finders with their
+   separators, the timing patterns, from version 2 on the alignment pattern
+   near the bottom right corner, and random modules everywhere else.*/
+static void _makeModules(unsigned char *modules, int n)
+{
+	int corner[3][2];
+	int ring;
+	int x;
+	int y;
+	int k;
+
+	for (k = 0; k < n * n; ++k){
+		modules[k] = rand() & 1;
+	}
+
+	corner[0][0] = 0;
+	corner[0][1] = 0;
+	corner[1][0] = n - 7;
+	corner[1][1] = 0;
+	corner[2][0] = 0;
+	corner[2][1] = n - 7;
+	for (k = 0; k < 3; ++k){
+		for (y = -1; y <= 7; ++y){
+			for (x = -1; x <= 7; ++x){
+				if (corner[k][0] + x < 0 || corner[k][1] + y < 0 || corner[k][0] + x >= n || corner[k][1] + y >= n){
+					continue;
+				}
+				//从中心数起的第几圈，3是外框，4是分隔带
+				ring = MAX(abs(x - 3), abs(y - 3));
+				modules[(corner[k][1] + y) * n + corner[k][0] + x] = (2 != ring && ring < 4);
+			}
+		}
+	}
+
+	for (k = 8; k < n - 8; ++k){
+		modules[6 * n + k] = !(k & 1);
+		modules[k * n + 6] = !(k & 1);
+	}
+
+	if (n > 21){
+		for (y = -2; y <= 2; ++y){
+			for (x = -2; x <= 2; ++x){
+				modules[(n - 7 + y) * n + n - 7 + x] = (1 != MAX(abs(x), abs(y)));
+			}
+		}
+	}
+}
+
+/*Draw the n*n code modules centered at (cx, cy), m pixels per module,
+   turned by angle degrees and then tilted: a point x pixels right of the
+   center is moved to x / (1 + tilt * x), y scaled the same.
+  Each pixel takes the module its center falls in.*/
+static void _drawWarpedCode(Mat &img, const unsigned char *modules, int n, double cx, double cy, double m,
+                            double angle, double tilt)
+{
+	double c;
+	double s;
+	double px;
+	double py;
+	double w;
+	double u;
+	double v;
+	int x;
+	int y;
+
+	c = cos(angle * CV_PI / 180);
+	s = sin(angle * CV_PI / 180);
+	for (y = 0; y < img.rows; ++y){
+		for (x = 0; x < img.cols; ++x){
+			px = x + 0.5 - cx;
+			py = y + 0.5 - cy;
+			w = 1 - tilt * px;
+			if (w <= 0){
+				continue;
+			}
+			px /= w;
+			py /= w;
+
+			u = (px * c + py * s) / m + n / 2.0;
+			v = (py * c - px * s) / m + n / 2.0;
+			if (u >= 0 && v >= 0 && u < n && v < n){
+				img.at<unsigned char>(y, x) = modules[(int)v * n + (int)u] ? 0x00 : 0xFF;
+			}
+		}
+	}
+}
+
+//生成带有若干二维码的二值图像，二维码四周留出静区
+static void _makeFrame(Mat &img, int width, int height, int ncodes)
+{
+	int i;
+	int m;
+	int n;
+	int size;
+
+	img.create(height, width, CV_8UC1);
+	img.setTo(Scalar(0xFF));
+	srand(1);
+	for (i = 0; i < ncodes; ++i){
+		m = 2 + rand() % 6;
+		n = 21 + 4 * (rand() % 5);
+		size = (n + 8) * m;
+		if (size < width && size < height){
+			_drawCode(img, 4 * m + rand() % (width - size), 4 * m + rand() % (height - size), m, n);
+		}
+	}
+}
+
+//复制locator找到的center，返回center数
+static int _saveCenters(QRLocator *locator, Mat &buf)
+{
+	buf.create(1, (int)sizeof(QRFinderCenter) * MAX(1, locator->CenterCount()), CV_8UC1);
+	memcpy(buf.data, locator->Centers(), sizeof(QRFinderCenter) * locator->CenterCount());
+
+	return locator->CenterCount();
+}
+
+//不同列扫描方式在整帧上的耗时，结果必须一致
+static int _benchVScan(void)
+{
+	static const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+	static const int engines[] = {QR_VSCAN_STRIDED, QR_VSCAN_ROWMAJOR, QR_VSCAN_TRANSPOSE, QR_VSCAN_TARGETED};
+	static const char *names[] = {"strided", "rowmajor", "transpose", "targeted"};
+	QRLocatorConfig config;
+	QRLocator *locator;
+	Mat expect;
+	Mat img;
+	int nexpect;
+	int s;
+	int e;
+	int round;
+	double start;
+	double cost;
+
+	locator = new QRLocator();
+	for (s = 0; s < 2; ++s){
+		_makeFrame(img, sizes[s][0], sizes[s][1], 4);
+		printf("vscan: %d x %d\n", sizes[s][0], sizes[s][1]);
+
+		nexpect = -1;
+		for (e = 0; e < 4; ++e){
+			QR_GetDefaultConfig(&config);
+			config.vscan = engines[e];
+			locator->SetConfig(config);
+
+			locator->LocateBinary(img);
+			if (nexpect < 0){
+				nexpect = _saveCenters(locator, expect);
+			} else if (nexpect != locator->CenterCount() ||
+			           0 != memcmp(expect.data, locator->Centers(), sizeof(QRFinderCenter) * nexpect)){
+				printf("  %-10s centers differ\n", names[e]);
+				delete locator;
+				return -1;
+			}
+
+			start = _now();
+			for (round = 0; round < 10; ++round){
+				locator->LocateBinary(img);
+			}
+			cost = (_now() - start) / 10;
+			printf("  %-10s %8.2f ms/frame  (%d centers, %d column pixels)\n", names[e], cost * 1000,
+			       locator->CenterCount(), locator->ScannedPixels());
+		}
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//彩色输入每秒处理的字节数，合并实现的结果必须和OpenCV相同
+static int _benchThreshold(void)
+{
+	static const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+	Mat frame;
+	Mat img;
+	Mat gray;
+	Mat binary;
+	Mat fusedGray;
+	Mat fusedBinary;
+	int *sums;
+	unsigned char *p;
+	size_t i;
+	int s;
+	int round;
+	double start;
+	double cost;
+
+	for (s = 0; s < 2; ++s){
+		//二值图像加上噪声作为彩色输入
+		_makeFrame(frame, sizes[s][0], sizes[s][1], 4);
+		img.create(frame.rows, frame.cols, CV_8UC3);
+		p = img.data;
+		for (i = 0; i < frame.total(); ++i){
+			*p++ = frame.data[i] / 2 + rand() % 64;
+			*p++ = frame.data[i] / 2 + rand() % 64;
+			*p++ = frame.data[i] / 2 + rand() % 64;
+		}
+		printf("threshold: %d x %d BGR\n", img.cols, img.rows);
+
+		gray.create(img.rows, img.cols, CV_8UC1);
+		binary.create(img.rows, img.cols, CV_8UC1);
+		fusedGray.create(img.rows, img.cols, CV_8UC1);
+		fusedBinary.create(img.rows, img.cols, CV_8UC1);
+		sums = (int *)malloc(sizeof(int) * img.cols);
+
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			cvtColor(img, gray, CV_RGB2GRAY);
+			adaptiveThreshold(gray, binary, 0xFF, ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY,
+			                  QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA);
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-8s %8.2f ms/frame  %6.2f GB/s\n", "opencv", cost * 1000, img.total() * 3 / cost / 1e9);
+
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			QR_GrayThreshold(img.data, (int)img.step, 3, img.cols, img.rows,
+			                 fusedGray.data, (int)fusedGray.step, fusedBinary.data, (int)fusedBinary.step,
+			                 QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA, sums);
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-8s %8.2f ms/frame  %6.2f GB/s\n", "fused", cost * 1000, img.total() * 3 / cost / 1e9);
+
+		free(sums);
+		if (0 != memcmp(gray.data, fusedGray.data, gray.total()) ||
+		    0 != memcmp(binary.data, fusedBinary.data, binary.total())){
+			printf("  fused result differs\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+//每像素1字节和1位两种二值图像：二值化+闭运算，以及逐行找跳变
+static int _benchBitmap(void)
+{
+	static const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+	Mat frame;
+	Mat img;
+	Mat gray;
+	Mat binary;
+	Mat unpacked;
+	Mat elem;
+	uint64_t *bits;
+	uint64_t *tmp;
+	int *sums;
+	int *edges;
+	unsigned char *p;
+	size_t i;
+	int words;
+	int total;
+	int s;
+	int y;
+	int round;
+	double start;
+	double cost;
+
+	elem = getStructuringElement(MORPH_ELLIPSE, Size(3, 3));
+	for (s = 0; s < 2; ++s){
+		_makeFrame(frame, sizes[s][0], sizes[s][1], 4);
+		img.create(frame.rows, frame.cols, CV_8UC3);
+		p = img.data;
+		for (i = 0; i < frame.total(); ++i){
+			*p++ = frame.data[i] / 2 + rand() % 64;
+			*p++ = frame.data[i] / 2 + rand() % 64;
+			*p++ = frame.data[i] / 2 + rand() % 64;
+		}
+
+		words = QR_BITMAP_WORDS(img.cols);
+		gray.create(img.rows, img.cols, CV_8UC1);
+		binary.create(img.rows, img.cols, CV_8UC1);
+		unpacked.create(img.rows, img.cols, CV_8UC1);
+		bits = (uint64_t *)malloc(sizeof(uint64_t) * words * img.rows);
+		tmp = (uint64_t *)malloc(sizeof(uint64_t) * words * img.rows);
+		sums = (int *)malloc(sizeof(int) * 2 * img.cols);
+		edges = (int *)malloc(sizeof(int) * img.cols);
+		printf("bitmap: %d x %d, binary %d KB as bytes, %d KB as bits\n", img.cols, img.rows,
+		       (int)(img.total() / 1024), (int)(sizeof(uint64_t) * words * img.rows / 1024));
+
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			QR_GrayThreshold(img.data, (int)img.step, 3, img.cols, img.rows, gray.data, (int)gray.step,
+			                 binary.data, (int)binary.step, QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA, sums);
+			morphologyEx(binary, binary, MORPH_CLOSE, elem);
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-6s binarize+close %8.2f ms/frame\n", "bytes", cost * 1000);
+
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			QR_GrayThresholdBits(img.data, (int)img.step, 3, img.cols, img.rows, gray.data, (int)gray.step,
+			                     bits, words, QR_CONFIG_THRESHOLD_BLOCK, QR_CONFIG_THRESHOLD_DELTA, sums);
+			QR_CloseBits(bits, bits, tmp, img.cols, img.rows, words);
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-6s binarize+close %8.2f ms/frame\n", "bits", cost * 1000);
+
+		QR_UnpackBits(bits, words, img.cols, img.rows, unpacked.data, (int)unpacked.step);
+		if (0 != memcmp(binary.data, unpacked.data, binary.total())){
+			printf("  bitmap result differs\n");
+			return -1;
+		}
+
+		total = 0;
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			for (y = 0; y < img.rows; ++y){
+				total += QR_FindTransitions(binary.data + y * binary.step, img.cols, 1, edges);
+			}
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-6s row transitions %7.2f ms/frame  (%d edges)\n", "bytes", cost * 1000, total / 10);
+
+		total = 0;
+		start = _now();
+		for (round = 0; round < 10; ++round){
+			for (y = 0; y < img.rows; ++y){
+				total += QR_FindBitTransitions(bits + y * words, img.cols, edges);
+			}
+		}
+		cost = (_now() - start) / 10;
+		printf("  %-6s row transitions %7.2f ms/frame  (%d edges)\n", "bits", cost * 1000, total / 10);
+
+		free(bits);
+		free(tmp);
+		free(sums);
+		free(edges);
+	}
+
+	return 0;
+}
+
+/*Draw up to 4 codes on a 2x2 grid, one per cell so that they never overlap,
+   and add salt and pepper noise to noise out of 1000 pixels.
+  The centers of all finders are returned in finders, in subpel units.*/
+static int _makeNoisyFrame(Mat &img, int width, int height, int noise, QRPoint *finders)
+{
+	Mat gray;
+	unsigned char *p;
+	int nfinders;
+	int cols;
+	int rows;
+	int cx;
+	int cy;
+	int x;
+	int y;
+	int m;
+	int n;
+	int size;
+	size_t i;
+
+	gray.create(height, width, CV_8UC1);
+	gray.setTo(Scalar(0xFF));
+	cols = 2;
+	rows = 2;
+	nfinders = 0;
+	for (cy = 0; cy < rows; ++cy){
+		for (cx = 0; cx < cols; ++cx){
+			m = 2 + rand() % 5;
+			n = 21 + 4 * (rand() % 5);
+			size = (n + 8) * m;
+			if (size >= width / cols || size >= height / rows){
+				continue;
+			}
+			x = cx * (width / cols) + 4 * m + rand() % (width / cols - size);
+			y = cy * (height / rows) + 4 * m + rand() % (height / rows - size);
+			_drawCode(gray, x, y, m, n);
+
+			//finder中心在左上角往里3.5个模块
+			finders[nfinders][0] = (2 * x + 7 * m) << (QR_FINDER_SUBPREC - 1);
+			finders[nfinders][1] = (2 * y + 7 * m) << (QR_FINDER_SUBPREC - 1);
+			finders[nfinders + 1][0] = (2 * x + (2 * n - 7) * m) << (QR_FINDER_SUBPREC - 1);
+			finders[nfinders + 1][1] = finders[nfinders][1];
+			finders[nfinders + 2][0] = finders[nfinders][0];
+			finders[nfinders + 2][1] = (2 * y + (2 * n - 7) * m) << (QR_FINDER_SUBPREC - 1);
+			nfinders += 3;
+		}
+	}
+
+	img.create(height, width, CV_8UC3);
+	p = img.data;
+	for (i = 0; i < gray.total(); ++i){
+		if (rand() % 1000 < noise){
+			p[0] = p[1] = p[2] = (rand() & 1) ? 0xFF : 0x00;
+		} else {
+			p[0] = p[1] = p[2] = gray.data[i] / 2 + 32 + rand() % 32;
+		}
+		p += 3;
+	}
+
+	return nfinders;
+}
+
+//噪声图像上的检出率和每帧耗时：闭运算、不做闭运算、用游程合并代替闭运算、两者都用
+static int _benchNoise(void)
+{
+	static const int noises[] = {5, 20};
+	static const int modes[][2] = {{1, 0}, {0, 0}, {0, 2}, {1, 2}};
+	QRLocatorConfig config;
+	QRLocator *locator;
+	QRPoint finders[12];
+	Mat raw;
+	Mat binary;
+	Mat qrimg;
+	const QRFinderCenter *c;
+	int nfinders;
+	int expected;
+	int found;
+	int dist;
+	int f;
+	int k;
+	int j;
+	int i;
+	int mode;
+	double start;
+	double cost;
+
+	locator = new QRLocator();
+	for (k = 0; k < 2; ++k){
+		printf("noise: 10 frames 1920 x 1080, %d/1000 noise pixels\n", noises[k]);
+
+		for (mode = 0; mode < 4; ++mode){
+			QR_GetDefaultConfig(&config);
+			config.morph_close = modes[mode][0];
+			config.min_run_px = modes[mode][1];
+			locator->SetConfig(config);
+
+			//每种方式用同样的10帧
+			srand(7);
+			expected = 0;
+			found = 0;
+			cost = 0;
+			for (f = 0; f < 10; ++f){
+				nfinders = _makeNoisyFrame(raw, 1920, 1080, noises[k], finders);
+				expected += nfinders;
+				start = _now();
+				locator->ProcessImage(raw, binary, qrimg);
+				cost += _now() - start;
+
+				//离finder中心不超过一个中心黑块宽度的center算检出
+				for (i = 0; i < nfinders; ++i){
+					c = locator->Centers();
+					for (j = 0; j < locator->CenterCount(); ++j){
+						dist = (c[j].pos[0] - finders[i][0]) * (c[j].pos[0] - finders[i][0]) +
+						       (c[j].pos[1] - finders[i][1]) * (c[j].pos[1] - finders[i][1]);
+						if (dist <= c[j].len * c[j].len){
+							found += 1;
+							break;
+						}
+					}
+				}
+			}
+
+			printf("  close=%d min_run=%d  recall %3d/%3d (%5.1f%%)  %8.2f ms/frame\n",
+			       modes[mode][0], modes[mode][1], found, expected, 100.0 * found / expected, cost * 1000 / 10);
+		}
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//分带多线程扫描的耗时，结果必须和单线程一致
+static int _benchThreads(void)
+{
+	static const int threads[] = {1, 2, 4, 8, 16};
+	static const int engines[] = {QR_VSCAN_ROWMAJOR, QR_VSCAN_STRIDED};
+	static const char *names[] = {"rowmajor", "strided"};
+	QRLocatorConfig config;
+	QRLocator *locator;
+	Mat expect;
+	Mat img;
+	int nexpect;
+	int t;
+	int e;
+	int round;
+	double start;
+	double cost;
+	double serial;
+
+	locator = new QRLocator();
+	_makeFrame(img, 3840, 2160, 4);
+	printf("threads: 3840 x 2160\n");
+
+	for (e = 0; e < 2; ++e){
+		nexpect = -1;
+		serial = 0;
+		for (t = 0; t < 5; ++t){
+			QR_GetDefaultConfig(&config);
+			config.vscan = engines[e];
+			config.threads = threads[t];
+			locator->SetConfig(config);
+
+			locator->LocateBinary(img);
+			if (nexpect < 0){
+				nexpect = _saveCenters(locator, expect);
+			} else if (nexpect != locator->CenterCount() ||
+			           0 != memcmp(expect.data, locator->Centers(), sizeof(QRFinderCenter) * nexpect)){
+				printf("  %-10s %2d threads: centers differ\n", names[e], threads[t]);
+				delete locator;
+				return -1;
+			}
+
+			start = _now();
+			for (round = 0; round < 10; ++round){
+				locator->LocateBinary(img);
+			}
+			cost = (_now() - start) / 10;
+			if (0 == t){
+				serial = cost;
+			}
+			printf("  %-10s %2d threads %8.2f ms/frame  x%.2f  (%d centers)\n", names[e], threads[t],
+			       cost * 1000, serial / cost, locator->CenterCount());
+		}
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//有一个center离(x, y)不超过一个模块时返回1
+static int _hasCenter(QRLocator *locator, int x, int y, int m)
+{
+	const QRFinderCenter *c;
+	int i;
+
+	for (i = 0; i < locator->CenterCount(); ++i){
+		c = locator->Centers() + i;
+		if (abs((c->pos[0] >> QR_FINDER_SUBPREC) - x) <= m && abs((c->pos[1] >> QR_FINDER_SUBPREC) - y) <= m){
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*A 12 MP frame with the default config: no module range is given, so the
+   automatic pyramid must shrink it by area and still find the three finders
+   of every code.*/
+static int _benchPyramid(void)
+{
+	static const int pyramids[] = {0, -1};
+	static const char *names[] = {"full", "auto"};
+	QRLocatorConfig config;
+	QRLocator *locator;
+	Mat img;
+	Mat raw;
+	Mat binary;
+	Mat qrimg;
+	int x[4];
+	int y[4];
+	int nfound;
+	int p;
+	int i;
+	int round;
+	double start;
+	double cost;
+
+	img.create(3000, 4000, CV_8UC1);
+	img.setTo(Scalar(0xFF));
+	srand(1);
+	for (i = 0; i < 4; ++i){
+		x[i] = 400 + (i & 1) * 2000;
+		y[i] = 400 + (i >> 1) * 1400;
+		_drawCode(img, x[i], y[i], 12, 25);
+	}
+
+	locator = new QRLocator();
+	printf("pyramid: 4000 x 3000\n");
+	for (p = 0; p < 2; ++p){
+		QR_GetDefaultConfig(&config);
+		config.pyramid = pyramids[p];
+		config.binary_out = 1;
+		locator->SetConfig(config);
+
+		cost = 0;
+		for (round = 0; round < 5; ++round){
+			img.copyTo(raw);
+			start = _now();
+			locator->ProcessImage(raw, binary, qrimg);
+			cost += _now() - start;
+		}
+		cost /= 5;
+
+		//三个finder的中心在3.5和21.5个模块处
+		nfound = 0;
+		for (i = 0; i < 4; ++i){
+			nfound += _hasCenter(locator, x[i] + 42, y[i] + 42, 12);
+			nfound += _hasCenter(locator, x[i] + 258, y[i] + 42, 12);
+			nfound += _hasCenter(locator, x[i] + 42, y[i] + 258, 12);
+		}
+		printf("  %s  %d levels  %4d x %4d scanned  %8.2f ms/frame  %2d/12 finders  (%d centers)\n", names[p],
+		       locator->PyramidLevels(), binary.cols, binary.rows, cost * 1000, nfound, locator->CenterCount());
+		if (12 != nfound || (pyramids[p] < 0 && 0 == locator->PyramidLevels())){
+			delete locator;
+			return -1;
+		}
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//在(x, y)处画一组1:1:3:1:1的竖条，只在行方向上产生finder line，像文字和条码一样
+static void _drawBars(Mat &img, int x, int y, int m, int h)
+{
+	rectangle(img, Rect(x, y, m, h), Scalar(0x00), CV_FILLED);
+	rectangle(img, Rect(x + 2 * m, y, 3 * m, h), Scalar(0x00), CV_FILLED);
+	rectangle(img, Rect(x + 6 * m, y, m, h), Scalar(0x00), CV_FILLED);
+}
+
+//LocateBinary的平均耗时
+static double _timeLocate(QRLocator *locator, Mat &img)
+{
+	double start;
+	int round;
+
+	locator->LocateBinary(img);
+	start = _now();
+	for (round = 0; round < 10; ++round){
+		locator->LocateBinary(img);
+	}
+
+	return (_now() - start) / 10;
+}
+
+/*Frames with 10k to 100k finder lines.
+  Dense finders: the line and cluster counts are not capped any more, and
+   every finder gives one cluster in each direction.
+  Bar groups scattered like text: many short lines close together, most of
+   which never form a cluster.*/
+static int _benchLines(void)
+{
+	static const int grids[] = {4, 16, 32, 64};
+	static const int groups[] = {1000, 4000, 16000};
+	QRLocator *locator;
+	Mat img;
+	int pitch;
+	int n;
+	int g;
+	int x;
+	int y;
+	double cost;
+
+	locator = new QRLocator();
+	pitch = 60;
+	for (g = 0; g < 4; ++g){
+		n = grids[g];
+		img.create(n * pitch + 40, n * pitch + 40, CV_8UC1);
+		img.setTo(Scalar(0xFF));
+		for (y = 0; y < n; ++y){
+			for (x = 0; x < n; ++x){
+				_drawFinder(img, 20 + x * pitch, 20 + y * pitch, 4);
+			}
+		}
+
+		cost = _timeLocate(locator, img);
+		if (locator->ClusterCount() != 2 * n * n){
+			printf("lines: %d finders, %d clusters\n", n * n, locator->ClusterCount());
+			delete locator;
+			return -1;
+		}
+		printf("lines: %5d finders %7d lines %6d clusters %8.2f ms/frame\n", n * n,
+		       locator->LineCount(), locator->ClusterCount(), cost * 1000);
+	}
+
+	srand(1);
+	for (g = 0; g < 3; ++g){
+		img.create(2000, 4000, CV_8UC1);
+		img.setTo(Scalar(0xFF));
+		for (n = 0; n < groups[g]; ++n){
+			_drawBars(img, rand() % 3960, rand() % 1960, 1 + rand() % 4, 4 + rand() % 32);
+		}
+
+		cost = _timeLocate(locator, img);
+		printf("lines: %5d bars    %7d lines %6d clusters %8.2f ms/frame\n", groups[g],
+		       locator->LineCount(), locator->ClusterCount(), cost * 1000);
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//紧密排列的小finder：从10个到10000个cluster，寻找交叉的耗时应随cluster数线性增长
+static int _benchCross(void)
+{
+	static const int grids[] = {2, 5, 10, 22, 50, 70};
+	QRLocator *locator;
+	Mat img;
+	int pitch;
+	int n;
+	int g;
+	int x;
+	int y;
+	double cost;
+
+	locator = new QRLocator();
+	pitch = 20;
+	for (g = 0; g < 6; ++g){
+		n = grids[g];
+		img.create(n * pitch + 20, n * pitch + 20, CV_8UC1);
+		img.setTo(Scalar(0xFF));
+		for (y = 0; y < n; ++y){
+			for (x = 0; x < n; ++x){
+				_drawFinder(img, 10 + x * pitch, 10 + y * pitch, 2);
+			}
+		}
+
+		cost = _timeLocate(locator, img);
+		if (locator->ClusterCount() != 2 * n * n || locator->CenterCount() != n * n){
+			printf("cross: %d finders, %d clusters, %d centers\n", n * n, locator->ClusterCount(), locator->CenterCount());
+			delete locator;
+			return -1;
+		}
+		printf("cross: %5d clusters %8.2f ms/frame %8.2f us/cluster\n", locator->ClusterCount(),
+		       cost * 1000, cost * 1e6 / locator->ClusterCount());
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+/*Pages of 1 to 200 codes, each found and cropped on its own, with a lone
+   finder in a corner as a false center.
+  There is no limit on the number of centers, the time per code should stay
+   flat as the page grows. The crops are compared with the box around all
+   the centers that was cropped before and handed to zbar.*/
+static int _benchCodes(void)
+{
+	static const int counts[] = {1, 2, 5, 20, 50, 100, 200};
+	QRLocator *locator;
+	const QRFinderCenter *c;
+	Mat img;
+	Mat raw;
+	Mat binary;
+	Mat qrimg;
+	double start;
+	double cost;
+	long cropped;
+	long bound;
+	int minx;
+	int miny;
+	int maxx;
+	int maxy;
+	int len;
+	int cols;
+	int round;
+	int g;
+	int n;
+	int i;
+
+	locator = new QRLocator();
+	for (g = 0; g < 7; ++g){
+		n = counts[g];
+		for (cols = 1; cols * cols < n; ++cols);
+		img.create(((n + cols - 1) / cols) * 200 + 120, cols * 200 + 120, CV_8UC1);
+		img.setTo(Scalar(0xFF));
+		srand(n);
+		for (i = 0; i < n; ++i){
+			_drawCode(img, 40 + (i % cols) * 200, 40 + (i / cols) * 200, 4, 33);
+		}
+		_drawFinder(img, img.cols - 44, img.rows - 44, 4);
+
+		start = _now();
+		for (round = 0; round < 5; ++round){
+			img.copyTo(raw);
+			locator->ProcessImage(raw, binary, qrimg);
+		}
+		cost = (_now() - start) / 5;
+
+		if (locator->CodeCount() != n || locator->Codes()[0].center[0] < 0){
+			printf("codes: %d codes drawn, %d found\n", n, locator->CodeCount());
+			delete locator;
+			return -1;
+		}
+
+		cropped = 0;
+		for (i = 0; i < locator->CodeCount(); ++i){
+			cropped += (long)locator->Codes()[i].width * locator->Codes()[i].height;
+		}
+
+		//原来裁剪的是包含所有center的外框
+		c = locator->Centers();
+		minx = miny = 0x7FFFFFFF;
+		maxx = maxy = 0;
+		len = 0;
+		for (i = 0; i < locator->CenterCount(); ++i){
+			minx = MIN(minx, c[i].pos[0] >> QR_FINDER_SUBPREC);
+			miny = MIN(miny, c[i].pos[1] >> QR_FINDER_SUBPREC);
+			maxx = MAX(maxx, c[i].pos[0] >> QR_FINDER_SUBPREC);
+			maxy = MAX(maxy, c[i].pos[1] >> QR_FINDER_SUBPREC);
+			len += c[i].len;
+		}
+		len = (len / locator->CenterCount() * 8 / 3) >> QR_FINDER_SUBPREC;
+		bound = (long)(MIN(img.cols, maxx + len) - MAX(0, minx - len)) * (MIN(img.rows, maxy + len) - MAX(0, miny - len));
+
+		printf("codes: %4d codes %4d centers %5d x %-5d %8.2f ms/page %6.3f ms/code, crops %8ld px, one box %8ld px\n",
+		       locator->CodeCount(), locator->CenterCount(), img.cols, img.rows, cost * 1000, cost * 1000 / n, cropped, bound);
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+//矫正、取样和解码测试共用的二维码：版本2、7、15，每个模块的像素数，不倾斜和倾斜
+#define BENCH_WARP_SIZES 3
+#define BENCH_WARP_TILTS 2
+
+static const int g_WarpSizes[BENCH_WARP_SIZES] = {25, 45, 77};
+static const int g_WarpPitches[BENCH_WARP_SIZES] = {6, 4, 4};
+static const double g_WarpTilts[BENCH_WARP_TILTS] = {0, 0.0015};
+
+//一个测试用例
+typedef struct QRWarpCase{
+	int    z;       //第几种尺寸
+	int    n;       //每边的模块数
+	int    pitch;   //每个模块的像素数
+	int    a;       //第几个角度
+	double angle;
+	int    t;       //为1时倾斜
+} QRWarpCase;
+
+typedef int (*QRWarpCheck)(QRLocator *locator, const QRWarpCase *c, void *arg);
+
+/*Draw the modules of a case at the center of a white frame with room for
+   the quiet zone and the tilt.
+  The tilt is scaled to the size of the code, so every code leans by about
+   the same fraction.*/
+static void _makeWarpedFrame(Mat &img, const unsigned char *modules, const QRWarpCase *c)
+{
+	img.create(c->n * c->pitch * 2 + 160, c->n * c->pitch * 2 + 160, CV_8UC1);
+	img.setTo(Scalar(0xFF));
+	_drawWarpedCode(img, modules, c->n, img.cols / 2.0, img.rows / 2.0, c->pitch, c->angle,
+	                g_WarpTilts[c->t] * 132 / (c->n * c->pitch));
+}
+
+//ProcessImage处理img副本的平均耗时，qrimg和结果留在locator中
+static double _timeProcess(QRLocator *locator, const Mat &img, Mat &qrimg)
+{
+	Mat raw;
+	Mat binary;
+	double start;
+	int round;
+
+	start = _now();
+	for (round = 0; round < 5; ++round){
+		img.copyTo(raw);
+		locator->ProcessImage(raw, binary, qrimg);
+	}
+
+	return (_now() - start) / 5;
+}
+
+//每种尺寸、角度和倾斜执行一次check，第一次失败时停止
+static int _forWarpedCodes(const double *angles, int nangles, QRWarpCheck check, void *arg)
+{
+	QRLocator *locator;
+	QRWarpCase c;
+	int ret;
+
+	locator = new QRLocator();
+	ret = 0;
+	for (c.z = 0; 0 == ret && c.z < BENCH_WARP_SIZES; ++c.z){
+		c.n = g_WarpSizes[c.z];
+		c.pitch = g_WarpPitches[c.z];
+		for (c.a = 0; 0 == ret && c.a < nangles; ++c.a){
+			c.angle = angles[c.a];
+			for (c.t = 0; 0 == ret && c.t < BENCH_WARP_TILTS; ++c.t){
+				ret = check(locator, &c, arg);
+			}
+		}
+	}
+	delete locator;
+
+	return ret;
+}
+
+//矫正后的图像在每个模块的中心取样，必须和画出的模块一致
+static int _checkRectify(QRLocator *locator, const QRWarpCase *c, void *arg)
+{
+	unsigned char modules[77 * 77];
+	QRLocatorConfig config;
+	const QRCodeRegion *region;
+	Mat img;
+	Mat qrimg;
+	double cost[2];
+	long area[2];
+	int wrong;
+	int side;
+	int mode;
+	int n;
+	int x;
+	int y;
+
+	n = c->n;
+	srand(n);
+	_makeModules(modules, n);
+	_makeWarpedFrame(img, modules, c);
+
+	config = locator->GetConfig();
+	for (mode = 0; mode < 2; ++mode){
+		config.rectify = mode;
+		locator->SetConfig(config);
+		cost[mode] = _timeProcess(locator, img, qrimg);
+
+		region = locator->Codes();
+		if (1 != locator->CodeCount() || region->center[0] < 0 || (n - 17) / 4 != region->version){
+			printf("rectify: %d modules at %.0f degrees not found\n", n, c->angle);
+			return -1;
+		}
+		area[mode] = (long)qrimg.cols * qrimg.rows;
+	}
+
+	//在每个模块的中心取样
+	side = (n + 2 * QR_CONFIG_RECTIFY_QUIET) * QR_CONFIG_RECTIFY_MODULE;
+	if (qrimg.cols != side || qrimg.rows != side){
+		printf("rectify: %d x %d image for %d modules\n", qrimg.cols, qrimg.rows, n);
+		return -1;
+	}
+	wrong = 0;
+	for (y = 0; y < n; ++y){
+		for (x = 0; x < n; ++x){
+			if ((qrimg.at<unsigned char>((QR_CONFIG_RECTIFY_QUIET + y) * QR_CONFIG_RECTIFY_MODULE + QR_CONFIG_RECTIFY_MODULE / 2,
+			                             (QR_CONFIG_RECTIFY_QUIET + x) * QR_CONFIG_RECTIFY_MODULE + QR_CONFIG_RECTIFY_MODULE / 2) < 0x80) !=
+			    modules[y * n + x]){
+				wrong += 1;
+			}
+		}
+	}
+
+	printf("rectify: v%-2d %d px %2.0f deg tilt %d  crop %7ld -> %6ld px  %6.2f -> %6.2f ms  %s  %4d / %d modules wrong\n",
+	       region->version, c->pitch, c->angle, c->t, area[0], area[1], cost[0] * 1000, cost[1] * 1000,
+	       locator->Transforms()[0].aligned ? "aligned" : "affine ", wrong, n * n);
+
+	return (wrong * 100 > n * n) ? -1 : 0;
+}
+
+/*Rotated and tilted codes, cropped around their parallelogram and warped
+   upright.
+  The warped image must sample back every module of the code it was drawn
+   from, the crop size is compared with the plain crop.*/
+static int _benchRectify(void)
+{
+	static const double angles[] = {0, 20, 45};
+
+	return _forWarpedCodes(angles, 3, _checkRectify, NULL);
+}
+
+//SaveGrids复制出的grid必须读回每个模块，并且给出二维码转过的方向
+static int _checkGrid(QRLocator *locator, const QRWarpCase *c, void *arg)
+{
+	unsigned char modules[77 * 77];
+	QRLocatorConfig config;
+	QRCodeGrid *grids;
+	Mat gridBuf;
+	Mat img;
+	Mat qrimg;
+	double cost[2];
+	long area;
+	long bytes;
+	int ngrids;
+	int wrong;
+	int mode;
+	int n;
+	int x;
+	int y;
+
+	n = c->n;
+	srand(n);
+	_makeModules(modules, n);
+	_makeWarpedFrame(img, modules, c);
+
+	config = locator->GetConfig();
+	area = 0;
+	for (mode = 0; mode < 2; ++mode){
+		config.grid = mode;
+		locator->SetConfig(config);
+		cost[mode] = _timeProcess(locator, img, qrimg);
+		if (0 == mode){
+			area = (long)qrimg.cols * qrimg.rows;
+		}
+	}
+
+	locator->SaveGrids(gridBuf, &grids, &ngrids);
+	if (1 != ngrids || (n - 17) / 4 != grids->version || n != grids->size){
+		printf("grid: %d modules at %.0f degrees not found\n", n, c->angle);
+		return -1;
+	}
+
+	wrong = 0;
+	for (y = 0; y < n; ++y){
+		for (x = 0; x < n; ++x){
+			wrong += QR_GRID_MODULE(grids, x, y) != modules[y * n + x];
+		}
+	}
+	bytes = sizeof(QRCodeGrid) + sizeof(uint64_t) * grids->size * grids->words;
+
+	printf("grid: v%-2d %d px %3.0f deg tilt %d  turned %d  crop %7ld -> %4ld bytes  %6.2f -> %6.2f ms  %3d pattern errors  %4d / %d modules wrong\n",
+	       grids->version, c->pitch, c->angle, c->t, grids->orientation, area, bytes, cost[0] * 1000, cost[1] * 1000,
+	       grids->errors, wrong, n * n);
+
+	return (wrong * 100 > n * n || grids->orientation != ((int)floor(c->angle / 90 + 0.5) & 3)) ? -1 : 0;
+}
+
+/*Codes turned every way and tilted, sampled straight into module grids.
+  The copy SaveGrids makes must read back every module of the code it was
+   drawn from, upright, and tell which way the code was turned; its size is
+   compared with the plain crop that would otherwise be passed on.*/
+static int _benchGrid(void)
+{
+	static const double angles[] = {0, 20, 100, 200, 290};
+
+	return _forWarpedCodes(angles, 5, _checkGrid, NULL);
+}
+
+//编码测试用二维码的参数，取自标准中的表
+typedef struct QRBenchCode{
+	int version;
+	int level;       //QR_ECC_xxx
+	int ecc;         //每块的纠错码字数
+	int blocks;
+	int align[4];    //校正图形中心的坐标
+	int nalign;
+} QRBenchCode;
+
+//GF(256)乘法，逐位计算，不依赖被测的实现
+static int _benchGfMul(int a, int b)
+{
+	int r;
+
+	r = 0;
+	for (; 0 != b; b >>= 1){
+		if (b & 1){
+			r ^= a;
+		}
+		a <<= 1;
+		if (a & 0x100){
+			a ^= 0x11D;
+		}
+	}
+
+	return r;
+}
+
+//一块数据码字的Reed-Solomon校验码字，生成多项式的根为alpha^0 .. alpha^(ecc-1)
+static void _benchReedSolomon(const unsigned char *data, int ndata, int ecc, unsigned char *check)
+{
+	int gen[32];
+	int root;
+	int factor;
+	int i;
+	int j;
+
+	memset(gen, 0, sizeof(gen));
+	gen[0] = 1;
+	root = 1;
+	for (i = 0; i < ecc; ++i){
+		//gen乘以(x - root)，系数从低次到高次
+		for (j = i + 1; j > 0; --j){
+			gen[j] = _benchGfMul(gen[j], root) ^ gen[j - 1];
+		}
+		gen[0] = _benchGfMul(gen[0], root);
+		root = _benchGfMul(root, 2);
+	}
+
+	memset(check, 0, ecc);
+	for (i = 0; i < ndata; ++i){
+		factor = data[i] ^ check[0];
+		memmove(check, check + 1, ecc - 1);
+		check[ecc - 1] = 0;
+		for (j = 0; j < ecc; ++j){
+			check[j] ^= _benchGfMul(gen[ecc - 1 - j], factor);
+		}
+	}
+}
+
+//把一块n*n的模块标记为功能图形并填上颜色
+static void _benchSetFunction(unsigned char *modules, unsigned char *func, int n, int x, int y, int black)
+{
+	modules[y * n + x] = (unsigned char)black;
+	func[y * n + x] = 1;
+}
+
+//字母数字模式的45个字符，按编码值排列
+static const char g_BenchAlnum[46] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+//字符在字母数字模式中的编码值，不在其中时为-1
+static int _benchAlnum(int c)
+{
+	const char *p;
+
+	p = (0 == c) ? NULL : strchr(g_BenchAlnum, c);
+
+	return (NULL == p) ? -1 : (int)(p - g_BenchAlnum);
+}
+
+//s开始的两个字节是汉字模式能表示的Shift JIS字符时返回1
+static int _benchKanji(const unsigned char *s, int len)
+{
+	if (len < 2 || s[1] < 0x40 || s[1] > 0xFC || 0x7F == s[1]){
+		return 0;
+	}
+
+	return (s[0] >= 0x81 && s[0] <= 0x9F) || (s[0] >= 0xE0 && s[0] <= 0xEA) || (0xEB == s[0] && s[1] <= 0xBF);
+}
+
+/*Split text into segments the simple way: digits go to numeric, the other
+   alphanumeric characters to alphanumeric, Shift JIS pairs to kanji and
+   the rest to byte, each run of one kind a segment.
+  It is not the shortest encoding, but every run length leaves a different
+   remainder group at the end of its segment.
+  Return: The length of the run at text, its mode in *mode.*/
+static int _benchSegment(const unsigned char *text, int len, int *mode)
+{
+	int k;
+
+	k = 0;
+	if (_benchKanji(text, len)){
+		*mode = 8;
+		while (_benchKanji(text + k, len - k)){
+			k += 2;
+		}
+	} else if (text[0] >= '0' && text[0] <= '9'){
+		*mode = 1;
+		while (k < len && text[k] >= '0' && text[k] <= '9'){
+			k += 1;
+		}
+	} else if (_benchAlnum(text[0]) >= 0){
+		*mode = 2;
+		while (k < len && _benchAlnum(text[k]) >= 10){
+			k += 1;
+		}
+	} else {
+		*mode = 4;
+		while (k < len && _benchAlnum(text[k]) < 0 && !_benchKanji(text + k, len - k)){
+			k += 1;
+		}
+	}
+
+	return k;
+}
+
+/*Encode text as a complete n*n code of the given version, level and mask,
+   1 for black, the way an encoder following the standard does: function
+   patterns, format and version information, the data codewords padded to
+   capacity, the check codewords of every block, interleaved and placed in
+   the zigzag order with the mask applied.
+  The segments are preceded by header, a structured append (3) or FNC1
+   (5, 9) mode, when it is not 0, and by an ECI designator when eci is not
+   -1.
+  Return: The number of data codewords, or -1 if text does not fit.*/
+static int _encodeCode(const char *text, int eci, int header, const QRBenchCode *code, int mask, unsigned char *modules)
+{
+	static const int formatLevel[4] = {1, 0, 3, 2};
+	unsigned char func[77 * 77];
+	unsigned char data[1600];  //段的开销最多时也放得下220个字符
+	unsigned char check[700];
+	unsigned char stream[700];
+	const unsigned char *seg;
+	unsigned int bits;
+	unsigned int rem;
+	int n;
+	int total;
+	int ndata;
+	int nshort;
+	int shortData;
+	int len;
+	int nbits;
+	int group;
+	int mode;
+	int count;
+	int v;
+	int ring;
+	int right;
+	int vert;
+	int k;
+	int i;
+	int j;
+	int x;
+	int y;
+
+	n = 4 * code->version + 17;
+	memset(modules, 0, n * n);
+	memset(func, 0, n * n);
+
+	for (k = 0; k < 3; ++k){
+		for (j = -1; j <= 7; ++j){
+			for (i = -1; i <= 7; ++i){
+				x = ((1 == k) ? n - 7 : 0) + i;
+				y = ((2 == k) ? n - 7 : 0) + j;
+				if (x >= 0 && y >= 0 && x < n && y < n){
+					ring = MAX(abs(i - 3), abs(j - 3));
+					_benchSetFunction(modules, func, n, x, y, 2 != ring && ring < 4);
+				}
+			}
+		}
+	}
+	for (k = 8; k < n - 8; ++k){
+		_benchSetFunction(modules, func, n, k, 6, !(k & 1));
+		_benchSetFunction(modules, func, n, 6, k, !(k & 1));
+	}
+	for (i = 0; i < code->nalign; ++i){
+		for (j = 0; j < code->nalign; ++j){
+			//和finder重叠的三个角上没有
+			if ((0 == i || 0 == j) && i + j <= code->nalign - 1 && (0 == i + j || code->nalign - 1 == i + j)){
+				continue;
+			}
+			for (y = -2; y <= 2; ++y){
+				for (x = -2; x <= 2; ++x){
+					_benchSetFunction(modules, func, n, code->align[i] + x, code->align[j] + y, 1 != MAX(abs(x), abs(y)));
+				}
+			}
+		}
+	}
+
+	//格式信息，15位BCH码
+	bits = (formatLevel[code->level] << 3) | mask;
+	rem = bits;
+	for (k = 0; k < 10; ++k){
+		rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+	}
+	bits = ((bits << 10) | rem) ^ 0x5412;
+	for (k = 0; k < 15; ++k){
+		x = (k < 8) ? 8 : (8 == k) ? 7 : 14 - k;
+		y = (k < 6) ? k : (6 == k) ? 7 : 8;
+		_benchSetFunction(modules, func, n, x, y, (bits >> k) & 1);
+		x = (k < 8) ? n - 1 - k : 8;
+		y = (k < 8) ? 8 : n - 15 + k;
+		_benchSetFunction(modules, func, n, x, y, (bits >> k) & 1);
+	}
+	_benchSetFunction(modules, func, n, 8, n - 8, 1);
+
+	//版本信息，18位BCH码
+	if (code->version >= 7){
+		rem = code->version;
+		for (k = 0; k < 12; ++k){
+			rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+		}
+		bits = (code->version << 12) | rem;
+		for (k = 0; k < 18; ++k){
+			_benchSetFunction(modules, func, n, n - 11 + k % 3, k / 3, (bits >> k) & 1);
+			_benchSetFunction(modules, func, n, k / 3, n - 11 + k % 3, (bits >> k) & 1);
+		}
+	}
+
+	total = 0;
+	for (k = 0; k < n * n; ++k){
+		total += !func[k];
+	}
+	total /= 8;
+	ndata = total - code->ecc * code->blocks;
+	group = (code->version <= 9) ? 0 : (code->version <= 26) ? 1 : 2;
+	len = (int)strlen(text);
+
+	//先写出全部的段再看放不放得下，结束符后补齐到字节，再交替填充0xEC和0x11
+	memset(data, 0, sizeof(data));
+	nbits = 0;
+	#define PUT_BITS(v, count) for (k = (count) - 1; k >= 0; --k, ++nbits) data[nbits >> 3] |= (((v) >> k) & 1) << (7 - (nbits & 7))
+	if (0 != header){
+		PUT_BITS(header, 4);
+		PUT_BITS(0x1234, (3 == header) ? 16 : (9 == header) ? 8 : 0);
+	}
+	if (eci >= 0){
+		PUT_BITS(7, 4);
+		if (eci < 0x80){
+			PUT_BITS(eci, 8);
+		} else if (eci < 0x4000){
+			PUT_BITS(0x8000 | eci, 16);
+		} else {
+			PUT_BITS(0xC00000 | eci, 24);
+		}
+	}
+	for (i = 0; i < len; i += count){
+		seg = (const unsigned char *)text + i;
+		count = _benchSegment(seg, len - i, &mode);
+		PUT_BITS(mode, 4);
+		switch (mode){
+		case 1:
+			PUT_BITS(count, 10 + 2 * group);
+			for (j = 0; j + 3 <= count; j += 3){
+				PUT_BITS((seg[j] - '0') * 100 + (seg[j + 1] - '0') * 10 + seg[j + 2] - '0', 10);
+			}
+			if (count - j == 2){
+				PUT_BITS((seg[j] - '0') * 10 + seg[j + 1] - '0', 7);
+			} else if (count - j == 1){
+				PUT_BITS(seg[j] - '0', 4);
+			}
+			break;
+		case 2:
+			PUT_BITS(count, 9 + 2 * group);
+			for (j = 0; j + 2 <= count; j += 2){
+				PUT_BITS(_benchAlnum(seg[j]) * 45 + _benchAlnum(seg[j + 1]), 11);
+			}
+			if (j < count){
+				PUT_BITS(_benchAlnum(seg[j]), 6);
+			}
+			break;
+		case 8:
+			PUT_BITS(count / 2, 8 + 2 * group);
+			for (j = 0; j < count; j += 2){
+				v = ((seg[j] << 8) | seg[j + 1]) - ((seg[j] < 0xE0) ? 0x8140 : 0xC140);
+				PUT_BITS((v >> 8) * 0xC0 + (v & 0xFF), 13);
+			}
+			break;
+		default:
+			PUT_BITS(count, (0 == group) ? 8 : 16);
+			for (j = 0; j < count; ++j){
+				PUT_BITS(seg[j], 8);
+			}
+			break;
+		}
+	}
+	if (nbits > 8 * ndata){
+		return -1;
+	}
+	PUT_BITS(0, MIN(4, 8 * ndata - nbits));
+	#undef PUT_BITS
+	for (i = (nbits + 7) / 8, k = 0; i < ndata; ++i, ++k){
+		data[i] = (k & 1) ? 0x11 : 0xEC;
+	}
+
+	//短块在前，每块的校验码字跟在全部数据之后
+	nshort = code->blocks - total % code->blocks;
+	shortData = total / code->blocks - code->ecc;
+	for (j = 0, k = 0; j < code->blocks; ++j){
+		len = shortData + (j >= nshort);
+		_benchReedSolomon(data + k, len, code->ecc, check + j * code->ecc);
+		k += len;
+	}
+	for (i = 0, k = 0; i <= shortData; ++i){
+		for (j = 0; j < code->blocks; ++j){
+			if (i < shortData + (j >= nshort)){
+				stream[k++] = data[j * shortData + MAX(0, j - nshort) + i];
+			}
+		}
+	}
+	for (i = 0; i < code->ecc; ++i){
+		for (j = 0; j < code->blocks; ++j){
+			stream[k++] = check[j * code->ecc + i];
+		}
+	}
+
+	//从右下角开始两列一组上下交替，剩余的位为0
+	k = 0;
+	for (right = n - 1; right >= 1; right -= 2){
+		if (6 == right){
+			right = 5;
+		}
+		for (vert = 0; vert < n; ++vert){
+			for (i = 0; i < 2; ++i){
+				x = right - i;
+				y = (0 == ((right + 1) & 2)) ? n - 1 - vert : vert;
+				if (func[y * n + x]){
+					continue;
+				}
+				if (k < total * 8){
+					modules[y * n + x] = (stream[k >> 3] >> (7 - (k & 7))) & 1;
+				}
+				switch (mask){
+				case 0: modules[y * n + x] ^= 0 == (x + y) % 2; break;
+				case 1: modules[y * n + x] ^= 0 == y % 2; break;
+				case 2: modules[y * n + x] ^= 0 == x % 3; break;
+				case 3: modules[y * n + x] ^= 0 == (x + y) % 3; break;
+				case 4: modules[y * n + x] ^= 0 == (x / 3 + y / 2) % 2; break;
+				case 5: modules[y * n + x] ^= 0 == x * y % 2 + x * y % 3; break;
+				case 6: modules[y * n + x] ^= 0 == (x * y % 2 + x * y % 3) % 2; break;
+				default: modules[y * n + x] ^= 0 == ((x + y) % 2 + x * y % 3) % 2; break;
+				}
+				k += 1;
+			}
+		}
+	}
+
+	return ndata;
+}
+
+//每个用例编码、镜像和不镜像各一次，QR_DecodePayload必须读回原来的文本和ECI
+static int _checkPayload(QRLocator *locator, const QRWarpCase *c, void *arg)
+{
+	static const int ecis[4] = {-1, 26, 899, 123456};  //没有ECI，1、2、3字节的指定符
+	static const int headers[4] = {0, 3, 5, 9};
+	static const QRBenchCode codes[BENCH_WARP_SIZES] = {
+		{ 2, QR_ECC_M, 16, 1, {6, 18}, 2},
+		{ 7, QR_ECC_Q, 18, 6, {6, 22, 38}, 3},
+		{15, QR_ECC_L, 22, 6, {6, 26, 48, 70}, 4},
+	};
+	unsigned char modules[77 * 77];
+	unsigned char flipped[77 * 77];
+	char text[700];
+	const QRBenchCode *code;
+	QRLocatorConfig config;
+	QRPayload *payload;
+	Mat img;
+	Mat qrimg;
+	double start;
+	double locate;
+	double decode;
+	int ndata;
+	int ret;
+	int mirror;
+	int round;
+	int header;
+	int kind;
+	int run;
+	int eci;
+	int len;
+	int n;
+	int k;
+
+	payload = (QRPayload *)arg;
+	code = codes + c->z;
+	n = c->n;
+	config = locator->GetConfig();
+	config.grid = 1;
+	locator->SetConfig(config);
+	for (mirror = 0; mirror < 2; ++mirror){
+		//从随机长度开始，放不下时减一重新生成，所以取随机长度和能放下的最长文本中较短的
+		//文本由数字、字母数字、可打印字符和汉字的随机长度的串连成
+		srand(100 * c->z + 10 * c->a + 2 * c->t + mirror);
+		eci = ecis[(c->a + c->t + 2 * mirror) & 3];
+		header = headers[(c->z + c->a + mirror) & 3];
+		len = 0;
+		do {
+			len = (len > 0) ? len - 1 : (rand() % 200 + 20);
+			run = 0;
+			kind = 0;
+			for (k = 0; k < len; ++k){
+				if (0 == run){
+					run = rand() % 9 + 1;
+					kind = rand() % 4;
+				}
+				run -= 1;
+				if (0 == kind){
+					text[k] = (char)('0' + rand() % 10);
+				} else if (1 == kind){
+					text[k] = g_BenchAlnum[rand() % 45];
+				} else if (2 == kind || k + 1 == len){
+					text[k] = (char)(' ' + rand() % 95);
+				} else {
+					text[k] = (char)((rand() & 1) ? 0x81 + rand() % 31 : 0xE0 + rand() % 11);
+					text[++k] = (char)(0x40 + rand() % 0xBC);
+					text[k] += (0x7F == (unsigned char)text[k]);
+				}
+			}
+			text[len] = 0;
+			ndata = _encodeCode(text, eci, header, code, (c->a * 3 + c->t + mirror) & 7, modules);
+		} while (ndata < 0);
+
+		//翻转几个模块，每块都在纠错能力之内
+		for (k = 0; k < 4; ++k){
+			modules[(rand() % (n - 18) + 9) * n + rand() % (n - 18) + 9] ^= 1;
+		}
+		if (mirror){
+			for (k = 0; k < n * n; ++k){
+				flipped[k] = modules[(k % n) * n + k / n];
+			}
+			memcpy(modules, flipped, n * n);
+		}
+
+		_makeWarpedFrame(img, modules, c);
+		locate = _timeProcess(locator, img, qrimg);
+		if (1 != locator->CodeCount() || NULL == locator->Grids() || 0 == locator->Grids()->size){
+			printf("payload: v%d at %.0f degrees not found\n", code->version, c->angle);
+			return -1;
+		}
+
+		start = _now();
+		for (round = 0; round < 100; ++round){
+			ret = QR_DecodePayload(locator->Grids(), payload);
+		}
+		decode = (_now() - start) / 100;
+
+		printf("payload: v%-2d %c %d px %3.0f deg tilt %d mirror %d  eci %6d  header %d  %3d bytes  %2d corrected  locate %6.2f ms  decode %6.1f us  %s\n",
+		       code->version, "LMQH"[code->level], c->pitch, c->angle, c->t, mirror, eci, header, len, payload->corrected,
+		       locate * 1000, decode * 1e6, (QR_PAYLOAD_OK == ret) ? "ok" : "FAILED");
+		if (QR_PAYLOAD_OK != ret || len != payload->length || 0 != memcmp(text, payload->data, len) || mirror != payload->mirrored ||
+		    eci != payload->eci){
+			printf("payload: error %d, %d bytes read\n", ret, payload->length);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*Codes encoded the way a standard encoder does, in numeric, alphanumeric,
+   byte and kanji segments after an ECI or header, turned, tilted and
+   mirrored, with some modules flipped, are located, sampled into grids
+   and decoded with QR_DecodePayload.
+  Every code must come back with its text and ECI; the decode is timed
+   against the location that found it.*/
+static int _benchPayload(void)
+{
+	static const double angles[] = {0, 100, 200};
+	QRPayload *payload;
+	int ret;
+
+	payload = new QRPayload;
+	ret = _forWarpedCodes(angles, 3, _checkPayload, payload);
+	delete payload;
+
+	return ret;
+}
+
+//ProcessImage会在原图上画出cluster，每次处理前重新复制
+static void _copyImages(Mat *src, Mat *dst, int count)
+{
+	int i;
+
+	for (i = 0; i < count; ++i){
+		src[i].copyTo(dst[i]);
+	}
+}
+
+/*The fallback of QR_DecodeCode: a code whose grid decodes must not reach
+   zbar, one whose grid is spoiled or missing must be handed to zbar with
+   its rectified crop, and nothing is left to try without a crop.*/
+static int _benchDecode(void)
+{
+	static const QRBenchCode code = { 2, QR_ECC_M, 16, 1, {6, 18}, 2};
+	static const int expect[4] = {QR_DECODE_NATIVE, QR_DECODE_ZBAR, QR_DECODE_ZBAR, QR_DECODE_NONE};
+	unsigned char modules[25 * 25];
+	QR_LOCATOR locator;
+	QRLocatorConfig config;
+	QRCodeGrid grid;
+	QRCodeGrid spoiled;
+	QRWarpCase c;
+	Mat img;
+	Mat binary;
+	Mat qrimg;
+	int ret;
+	int k;
+
+	c.z = 0;
+	c.n = 25;
+	c.pitch = 6;
+	c.a = 0;
+	c.angle = 20;
+	c.t = 0;
+	_encodeCode("QR_DECODECODE 0123456789", -1, 0, &code, 3, modules);
+	_makeWarpedFrame(img, modules, &c);
+
+	QR_CreateDecoder();
+	locator = QR_CreateLocator();
+	QR_GetDefaultConfig(&config);
+	config.rectify = 1;
+	config.grid = 1;
+	QR_SetLocatorConfig(locator, &config);
+	QR_Locate(locator, img, binary, qrimg);
+	if (1 != QR_GetCodeCount(locator) || 0 != QR_GetCodeGrid(locator, 0, &grid) || 0 != QR_GetCodeImage(locator, 0, qrimg)){
+		printf("decode: code not found\n");
+		QR_DestroyLocator(locator);
+		return -1;
+	}
+
+	//尺寸为0的grid不是合法的版本，只能交给zbar
+	spoiled = grid;
+	spoiled.size = 0;
+
+	ret = 0;
+	for (k = 0; 0 == ret && k < 4; ++k){
+		switch (k){
+		case 0: ret = QR_DecodeCode(&grid, qrimg.data, qrimg.cols, qrimg.rows); break;
+		case 1: ret = QR_DecodeCode(&spoiled, qrimg.data, qrimg.cols, qrimg.rows); break;
+		case 2: ret = QR_DecodeCode(NULL, qrimg.data, qrimg.cols, qrimg.rows); break;
+		default: ret = QR_DecodeCode(&spoiled, NULL, 0, 0); break;
+		}
+		printf("decode: %-14s %s\n", (0 == k) ? "grid" : (1 == k) ? "spoiled grid" : (2 == k) ? "no grid" : "no crop",
+		       (QR_DECODE_NATIVE == ret) ? "native" : (QR_DECODE_ZBAR == ret) ? "zbar" : "none");
+		ret = (expect[k] == ret) ? 0 : -1;
+	}
+	QR_DestroyLocator(locator);
+
+	return ret;
+}
+
+//批量接口：一幅12M的大图加上64幅小图，结果必须和逐幅处理一致
+static int _benchBatch(void)
+{
+	static const int threads[] = {1, 2, 4, 8};
+	QRBatchResult *results;
+	QRLocator *locator;
+	QR_BATCH batch;
+	Mat images[65];
+	Mat work[65];
+	Mat binary;
+	Mat qrimg;
+	int status[65];
+	int nfound;
+	int t;
+	int i;
+	int round;
+	double start;
+	double cost;
+
+	_makeFrame(images[0], 4000, 3000, 4);
+	for (i = 1; i < 65; ++i){
+		_makeFrame(images[i], 320 + 8 * i, 240 + 4 * i, 1);
+	}
+
+	locator = new QRLocator();
+	_copyImages(images, work, 65);
+	start = _now();
+	for (i = 0; i < 65; ++i){
+		status[i] = locator->ProcessImage(work[i], binary, qrimg);
+	}
+	cost = _now() - start;
+	delete locator;
+	printf("batch: 1 x 4000 x 3000 + 64 small images\n");
+	printf("  one by one  %8.2f ms/batch\n", cost * 1000);
+
+	results = new QRBatchResult[65];
+	for (t = 0; t < 4; ++t){
+		batch = QR_CreateBatch(threads[t], NULL);
+		_copyImages(images, work, 65);
+		QR_ProcessBatch(batch, work, 65, results);
+		for (i = 0; i < 65; ++i){
+			if (status[i] != results[i].status){
+				printf("  %d threads: image %d status differs\n", threads[t], i);
+				QR_DestroyBatch(batch);
+				delete [] results;
+				return -1;
+			}
+		}
+
+		cost = 0;
+		for (round = 0; round < 5; ++round){
+			_copyImages(images, work, 65);
+			start = _now();
+			nfound = QR_ProcessBatch(batch, work, 65, results);
+			cost += _now() - start;
+		}
+		cost /= 5;
+		printf("  %2d threads  %8.2f ms/batch  (%d codes)\n", threads[t], cost * 1000, nfound);
+		QR_DestroyBatch(batch);
+	}
+
+	delete [] results;
+
+	return 0;
+}
+
+//流水线的结果必须按顺序到达，并且和逐帧处理相同，包括画在帧上的标记
+static int _checkResult(const QRPipelineResult *result, int frame, const int *status, const int *counts,
+                        const Mat *centers, const Mat *drawn)
+{
+	if (result->frameId != frame || result->status != status[frame] || result->ncenters != counts[frame] ||
+	    0 != memcmp(result->centers, centers[frame].data, sizeof(QRFinderCenter) * counts[frame]) ||
+	    result->frame.rows != drawn[frame].rows || result->frame.cols != drawn[frame].cols ||
+	    0 != memcmp(result->frame.data, drawn[frame].data, drawn[frame].total() * drawn[frame].elemSize())){
+		printf("  frame %d differs\n", frame);
+		return -1;
+	}
+
+	return 0;
+}
+
+//流水线：各阶段的耗时，以及流水线和逐帧处理的吞吐量，结果必须一致
+static int _benchPipeline(void)
+{
+	QRPipelineResult result;
+	QRLocator *locator;
+	QR_PIPELINE pipeline;
+	Mat frames[16];
+	Mat drawn[16];
+	Mat raw;
+	Mat binary;
+	Mat qrimg;
+	int status[16];
+	int counts[16];
+	Mat centers[16];
+	double stages[3];
+	double start;
+	double cost;
+	int next;
+	int i;
+
+	for (i = 0; i < 16; ++i){
+		_makeFrame(frames[i], 1920, 1080, 1 + i % 4);
+	}
+
+	//逐帧处理，同时统计每个阶段的耗时
+	locator = new QRLocator();
+	memset(stages, 0, sizeof(stages));
+	for (i = 0; i < 16; ++i){
+		frames[i].copyTo(raw);
+		start = _now();
+		locator->BinarizeFrame(raw, binary);
+		stages[0] += _now() - start;
+		start = _now();
+		locator->ScanFrame();
+		stages[1] += _now() - start;
+		start = _now();
+		status[i] = locator->FinishFrame(raw, qrimg);
+		stages[2] += _now() - start;
+		counts[i] = _saveCenters(locator, centers[i]);
+		raw.copyTo(drawn[i]);
+	}
+	delete locator;
+
+	printf("pipeline: 16 frames 1920 x 1080\n");
+	printf("  stages      binarize %.2f  scan %.2f  finish %.2f ms/frame\n",
+	       stages[0] * 1000 / 16, stages[1] * 1000 / 16, stages[2] * 1000 / 16);
+	printf("  serial      %8.2f ms/frame\n", (stages[0] + stages[1] + stages[2]) * 1000 / 16);
+
+	pipeline = QR_CreatePipeline(0, NULL);
+	next = 0;
+	start = _now();
+	for (i = 0; i < 16; ++i){
+		while (1 == QR_PushFrame(pipeline, frames[i], i)){
+			QR_PopResult(pipeline, &result, 1);
+			if (0 != _checkResult(&result, next++, status, counts, centers, drawn)){
+				QR_DestroyPipeline(pipeline);
+				return -1;
+			}
+		}
+	}
+	while (1 == QR_PopResult(pipeline, &result, 1)){
+		if (0 != _checkResult(&result, next++, status, counts, centers, drawn)){
+			QR_DestroyPipeline(pipeline);
+			return -1;
+		}
+	}
+	cost = _now() - start;
+	QR_DestroyPipeline(pipeline);
+
+	printf("  pipelined   %8.2f ms/frame  (%d frames)\n", cost * 1000 / 16, next);
+
+	return 0;
+}
+
+//分段读入时重复使用同一块图像
+typedef struct QRTileReader{
+	Mat *tile;
+	int  y;
+} QRTileReader;
+
+static int _readTileRows(void *arg, unsigned char *dst, int step, int rows)
+{
+	QRTileReader *reader;
+	int i;
+
+	reader = (QRTileReader *)arg;
+	for (i = 0; i < rows; ++i){
+		memcpy(dst + (size_t)i * step, reader->tile->ptr<uchar>(reader->y % reader->tile->rows), reader->tile->cols);
+		reader->y += 1;
+	}
+
+	return 0;
+}
+
+/*A 2000 x 40000 image made of the same 2000 x 2000 tile, located in strips;
+   every tile must give as many centers as the tile located whole, and
+   every row must be scanned once.
+  The second pass runs on a locator that has built a thread pool in
+   ProcessImage, which then bands the binarize of every strip.*/
+static int _benchStrip(void)
+{
+	static const int strips[] = {64, 256, 1024};
+	static const int threads[] = {0, 4};
+	QRLocatorConfig config;
+	QRTileReader reader;
+	QRLocator *locator;
+	Mat tile;
+	Mat raw;
+	Mat binary;
+	Mat qrimg;
+	int expected;
+	int found;
+	int s;
+	int t;
+	double start;
+	double cost;
+
+	_makeFrame(tile, 2000, 2000, 4);
+	locator = new QRLocator();
+	QR_GetDefaultConfig(&config);
+	config.pyramid = 0;
+	expected = 0;
+	for (t = 0; t < 2; ++t){
+		config.threads = threads[t];
+		locator->SetConfig(config);
+		tile.copyTo(raw);
+		locator->ProcessImage(raw, binary, qrimg);
+		if (0 == t){
+			expected = locator->CenterCount() * 20;
+		}
+
+		printf("strip: 2000 x 40000, %d threads\n", threads[t]);
+		for (s = 0; s < 3; ++s){
+			reader.tile = &tile;
+			reader.y = 0;
+			start = _now();
+			found = locator->LocateStrips(_readTileRows, &reader, 2000, 40000, 1, strips[s], NULL, NULL);
+			cost = _now() - start;
+			printf("  %4d rows  %8.2f ms  %3d/%3d centers  %5d rows scanned  %6d KB image buffer\n", strips[s], cost * 1000,
+			       found, expected, locator->ScannedRows(), 2000 * (strips[s] + 2 * QR_CONFIG_STRIP_OVERLAP) / 1024);
+			if (found != expected || 40000 != locator->ScannedRows()){
+				delete locator;
+				return -1;
+			}
+		}
+	}
+
+	delete locator;
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *name;
+
+	name = (argc > 1) ? argv[1] : "all";
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "transition")){
+		if (0 != _benchTransition()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "vscan")){
+		if (0 != _benchVScan()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "threshold")){
+		if (0 != _benchThreshold()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "bitmap")){
+		if (0 != _benchBitmap()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "noise")){
+		if (0 != _benchNoise()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "threads")){
+		if (0 != _benchThreads()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "pyramid")){
+		if (0 != _benchPyramid()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "lines")){
+		if (0 != _benchLines()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "cross")){
+		if (0 != _benchCross()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "codes")){
+		if (0 != _benchCodes()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "rectify")){
+		if (0 != _benchRectify()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "grid")){
+		if (0 != _benchGrid()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "payload")){
+		if (0 != _benchPayload()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "decode")){
+		if (0 != _benchDecode()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "batch")){
+		if (0 != _benchBatch()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "pipeline")){
+		if (0 != _benchPipeline()){
+			return -1;
+		}
+	}
+
+	if (0 == strcmp(name, "all") || 0 == strcmp(name, "strip")){
+		if (0 != _benchStrip()){
+			return -1;
+		}
+	}
+
+	return 0;
+}
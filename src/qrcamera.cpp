@@ -8,35 +8,54 @@ using namespace std;
 
 #include <stdio.h>
 #include "locator.h"
+#include "pipeline.h"
+
+static void _showResult(const QRPipelineResult *result)
+{
+	imshow("RAW", result->frame);
+	if (false == result->qrimg.empty()){
+		imshow("QR", result->qrimg);
+	}
+}
 
 int main( int argc, char* argv[])
 {
 	int key;
+	int frameId;
 	VideoCapture capture(0);
+	QR_PIPELINE pipeline;
+	QRPipelineResult result;
 	Mat raw;
-	Mat qrcode;
-	Mat binary;
 
 	capture >> raw;
 	printf("Raw image size [%d * %d]\n", raw.cols, raw.rows);
 
+	//三个阶段在不同的线程上处理相邻的帧
+	pipeline = QR_CreatePipeline(0, NULL);
+
 	key = 0;
+	frameId = 0;
 	while( 'q' != key){
 		//capture
 		capture >> raw;
 
-		//processing
-		QR_ProcessImage(raw, binary, qrcode);
+		//processing，没有空闲的帧时先取走最早的结果
+		while (1 == QR_PushFrame(pipeline, raw, frameId)){
+			QR_PopResult(pipeline, &result, 1);
+			_showResult(&result);
+		}
+		frameId += 1;
 
-		//show image
-		imshow("RAW", raw);
-		if (false == qrcode.empty()){
-			imshow("QR", qrcode);
+		//show image，显示的是已经处理完、画上了标记的帧
+		while (1 == QR_PopResult(pipeline, &result, 0)){
+			_showResult(&result);
 		}
 
 		key = waitKey(1);
 	}
 
+	QR_DestroyPipeline(pipeline);
+
 	return 0;
 }
 
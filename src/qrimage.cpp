@@ -36,6 +36,10 @@ static int _loadImage( char * name, Mat *image)
 int main( int argc, char** argv )
 {
 	int ret;
+	int i;
+	QR_LOCATOR locator;
+	QRLocatorConfig config;
+	QRCodeGrid grid;
 	Mat raw;
 	Mat edges;
 	Mat qrcode;
@@ -53,19 +57,32 @@ int main( int argc, char** argv )
 
 	QR_CreateDecoder();
 
-	//processing
-	QR_ProcessImage(raw, edges, qrcode);
+	//processing，需要显示二值图像
+	locator = QR_CreateLocator();
+	QR_GetDefaultConfig(&config);
+	config.binary_out = 1;
+	config.rectify = 1;
+	config.grid = 1;
+	QR_SetLocatorConfig(locator, &config);
+	QR_Locate(locator, raw, edges, qrcode);
 
 	imshow("RAW", raw);
 	imshow("EDGES", edges);
 
 	if (false == qrcode.empty()){
 		imshow("QR", qrcode);
-		QR_Decode(qrcode.data, qrcode.cols, qrcode.rows);
+	}
+
+	//每个二维码先从取样的grid直接解码，解不出时zbar再扫描矫正后的小图
+	for (i = 0; i < QR_GetCodeCount(locator); ++i){
+		QR_GetCodeImage(locator, i, qrcode);
+		QR_DecodeCode((0 == QR_GetCodeGrid(locator, i, &grid)) ? &grid : NULL, qrcode.data, qrcode.cols, qrcode.rows);
 	}
 
     waitKey(0); // Wait for a keystroke in the window
 
+	QR_DestroyLocator(locator);
+
     return 0;
 } 
 
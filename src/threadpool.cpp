@@ -0,0 +1,243 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "threadpool.h"
+
+struct QRThreadPool;
+
+//工作线程，id从1开始，0是调用QR_RunTasks的线程
+typedef struct QRWorker{
+	struct QRThreadPool *pool;
+	pthread_t            thread;
+	int                  id;
+} QRWorker;
+
+//一次QR_RunTasks的任务，放在调用者的栈上
+typedef struct QRTaskSet{
+	QRTaskFunc        func;
+	void             *arg;
+	int               ntasks;
+	int               next;      //下一个要领取的任务
+	int               finished;  //已经执行完的任务数
+	struct QRTaskSet *link;      //更早加入的任务组
+} QRTaskSet;
+
+struct QRThreadPool{
+	QRWorker       *workers;
+	int             nthreads;
+	pthread_mutex_t lock;
+	pthread_cond_t  wake;
+
+	//还没完成的任务组，最新的在前，最外层的在最后
+	QRTaskSet      *sets;
+	QRTaskSet      *root;
+
+	unsigned int    generation;
+	int             quit;
+};
+
+//调用线程在池中的编号，不是池中的线程时为0
+static int _workerId(const QRThreadPool *pool)
+{
+	pthread_t self;
+	int i;
+
+	self = pthread_self();
+	for (i = 0; i < pool->nthreads; ++i){
+		if (pthread_equal(self, pool->workers[i].thread)){
+			return pool->workers[i].id;
+		}
+	}
+
+	return 0;
+}
+
+//从最新的任务组开始领取一个任务，stop之前更早的任务组不领取，NULL时全部可以领取
+static QRTaskSet* _claimTask(QRThreadPool *pool, const QRTaskSet *stop, int *index)
+{
+	QRTaskSet *set;
+
+	for (set = pool->sets; NULL != set; set = set->link){
+		if (set->next < set->ntasks){
+			*index = set->next++;
+			return set;
+		}
+		if (set == stop){
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*Run tasks until target is finished; for a pool thread target is NULL and it
+   runs tasks until the QR_RunTasks call of its generation returns.
+  Nested task sets are taken before the older ones, so the work a long task
+   hands out is done first by whichever thread is free.
+  Called and returns with the lock held.*/
+static void _helpTasks(QRThreadPool *pool, QRTaskSet *target, unsigned int generation, int worker)
+{
+	QRTaskSet *set;
+	int index;
+
+	for (;;){
+		if (NULL != target){
+			if (target->finished == target->ntasks){
+				break;
+			}
+		} else if (NULL == pool->root || generation != pool->generation){
+			break;
+		}
+
+		set = _claimTask(pool, target, &index);
+		if (NULL == set){
+			pthread_cond_wait(&pool->wake, &pool->lock);
+			continue;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+		set->func(set->arg, index, worker);
+		pthread_mutex_lock(&pool->lock);
+
+		//任务组的所有者在等它完成
+		set->finished += 1;
+		if (set->finished == set->ntasks){
+			pthread_cond_broadcast(&pool->wake);
+		}
+	}
+
+	return;
+}
+
+static void* _worker(void *arg)
+{
+	QRThreadPool *pool;
+	QRWorker *self;
+	unsigned int seen;
+
+	self = (QRWorker *)arg;
+	pool = self->pool;
+	seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;){
+		while (seen == pool->generation && !pool->quit){
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if (pool->quit){
+			break;
+		}
+		seen = pool->generation;
+		_helpTasks(pool, NULL, seen, self->id);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+QRThreadPool* QR_CreateThreadPool(int nthreads)
+{
+	QRThreadPool *pool;
+	int i;
+
+	pool = (QRThreadPool *)calloc(1, sizeof(QRThreadPool));
+	if (NULL == pool){
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+
+	if (nthreads > 1){
+		pool->workers = (QRWorker *)calloc(nthreads - 1, sizeof(QRWorker));
+		for (i = 0; NULL != pool->workers && i < nthreads - 1; ++i){
+			pool->workers[i].pool = pool;
+			pool->workers[i].id = i + 1;
+			if (0 != pthread_create(&pool->workers[i].thread, NULL, _worker, pool->workers + i)){
+				break;
+			}
+			pool->nthreads += 1;
+		}
+	}
+
+	return pool;
+}
+
+void QR_DestroyThreadPool(QRThreadPool *pool)
+{
+	int i;
+
+	if (NULL == pool){
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->nthreads; ++i){
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+
+	return;
+}
+
+int QR_ThreadPoolSize(const QRThreadPool *pool)
+{
+	return (NULL == pool) ? 1 : pool->nthreads + 1;
+}
+
+void QR_RunTasks(QRThreadPool *pool, QRTaskFunc func, void *arg, int ntasks)
+{
+	QRTaskSet **p;
+	QRTaskSet set;
+	int worker;
+	int i;
+
+	if (NULL == pool || 0 == pool->nthreads || ntasks <= 1){
+		worker = (NULL == pool) ? 0 : _workerId(pool);
+		for (i = 0; i < ntasks; ++i){
+			func(arg, i, worker);
+		}
+		return;
+	}
+
+	set.func = func;
+	set.arg = arg;
+	set.ntasks = ntasks;
+	set.next = 0;
+	set.finished = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	set.link = pool->sets;
+	pool->sets = &set;
+
+	//没有正在进行的调用时唤醒所有线程，否则是某个任务里的嵌套调用
+	if (NULL == pool->root){
+		pool->root = &set;
+		pool->generation += 1;
+		worker = 0;
+	} else {
+		worker = _workerId(pool);
+	}
+	pthread_cond_broadcast(&pool->wake);
+
+	_helpTasks(pool, &set, 0, worker);
+
+	for (p = &pool->sets; *p != &set; p = &(*p)->link){
+	}
+	*p = set.link;
+	if (pool->root == &set){
+		pool->root = NULL;
+		pthread_cond_broadcast(&pool->wake);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return;
+}
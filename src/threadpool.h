@@ -0,0 +1,25 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+/*A fixed set of worker threads running indexed tasks.
+  QR_RunTasks hands out the indices 0 .. ntasks-1 one at a time to whichever
+   thread is free, the calling thread takes part as well, and returns once
+   every task has finished.
+  A pool runs one QR_RunTasks call at a time, but a task may itself call
+   QR_RunTasks on the same pool: the nested tasks are handed out before the
+   outer ones still waiting, to whichever thread becomes free, and the
+   nested call returns once they have finished, so a long task can spread
+   its own work over threads that would otherwise sit idle.
+  worker tells which thread runs a task, 0 for the caller and 1 .. size-1
+   for the pool threads, so each thread can use its own context.*/
+typedef struct QRThreadPool QRThreadPool;
+
+typedef void (*QRTaskFunc)(void *arg, int index, int worker);
+
+//nthreads包括调用者自己，所以只创建nthreads-1个线程
+extern QRThreadPool* QR_CreateThreadPool(int nthreads);
+extern void QR_DestroyThreadPool(QRThreadPool *pool);
+extern int  QR_ThreadPoolSize(const QRThreadPool *pool);
+extern void QR_RunTasks(QRThreadPool *pool, QRTaskFunc func, void *arg, int ntasks);
+
+#endif
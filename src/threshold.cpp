@@ -0,0 +1,252 @@
+#include <stddef.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "threshold.h"
+
+/*Fixed point luma weights used by OpenCV for CV_RGB2GRAY on 8-bit images,
+   applied to channels 0, 1 and 2 in that order.*/
+#define QR_LUMA_SHIFT (14)
+#define QR_LUMA_C0    (4899)
+#define QR_LUMA_C1    (9617)
+#define QR_LUMA_C2    (1868)
+
+#define QR_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define QR_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+static unsigned char _luma(const unsigned char *p)
+{
+	return (unsigned char)((p[0] * QR_LUMA_C0 + p[1] * QR_LUMA_C1 + p[2] * QR_LUMA_C2 +
+	                        (1 << (QR_LUMA_SHIFT - 1))) >> QR_LUMA_SHIFT);
+}
+
+static void _grayRow(const unsigned char *src, int channels, int width, unsigned char *gray)
+{
+	int x;
+
+	if (1 == channels){
+		for (x = 0; x < width; ++x){
+			gray[x] = src[x];
+		}
+	} else {
+		for (x = 0; x < width; ++x){
+			gray[x] = _luma(src + x * channels);
+		}
+	}
+}
+
+//把一行转成灰度，同时把它加到列和上并减去离开窗口的一行
+static void _lumaRow(const unsigned char *src, int channels, int width,
+                     unsigned char *gray, const unsigned char *sub, int *sums)
+{
+	int x;
+
+	_grayRow(src, channels, width, gray);
+
+	//行还在缓存里，分开写便于编译器向量化
+	for (x = 0; x < width; ++x){
+		sums[x] += gray[x] - sub[x];
+	}
+}
+
+//已经是灰度的行直接移动窗口，包括超出图像底部后重复的最后一行
+static void _slideRows(const unsigned char *add, const unsigned char *sub, int width, int *sums)
+{
+	int x;
+
+	for (x = 0; x < width; ++x){
+		sums[x] += add[x] - sub[x];
+	}
+}
+
+static void _addRow(const unsigned char *add, int width, int *sums)
+{
+	int x;
+
+	for (x = 0; x < width; ++x){
+		sums[x] += add[x];
+	}
+}
+
+/*Threshold one row against the sliding window sum of the column sums.
+  mean < gray + delta is tested as sum + area/2 < (gray + delta) * area, which
+   is the same as rounding sum/area to the nearest integer for an odd area and
+   avoids the division.*/
+static void _thresholdRow(const int *sums, const unsigned char *gray, int width,
+                          int r, int delta, unsigned char *binary)
+{
+	int area;
+	int half;
+	int sum;
+	int end;
+	int x;
+	int k;
+
+	area = (2 * r + 1) * (2 * r + 1);
+	half = area / 2;
+
+	sum = (r + 1) * sums[0];
+	for (k = 1; k <= r; ++k){
+		sum += sums[QR_MIN(k, width - 1)];
+	}
+
+#define QR_THRESHOLD_PIXEL(lo, hi) \
+	do { \
+		binary[x] = (sum + half < (gray[x] + delta) * area) ? 0xFF : 0x00; \
+		sum += sums[hi] - sums[lo]; \
+	} while (0)
+
+	//左右边界处窗口下标需要截断，中间部分不需要
+	x = 0;
+	end = QR_MIN(r, width);
+	for (; x < end; ++x){
+		QR_THRESHOLD_PIXEL(0, QR_MIN(x + r + 1, width - 1));
+	}
+
+	end = width - r - 1;
+	for (; x < end; ++x){
+		QR_THRESHOLD_PIXEL(x - r, x + r + 1);
+	}
+
+	for (; x < width; ++x){
+		QR_THRESHOLD_PIXEL(QR_MAX(x - r, 0), width - 1);
+	}
+
+#undef QR_THRESHOLD_PIXEL
+
+	return;
+}
+
+//把一行0x00/0xFF打包成位，每16个像素一次movemask
+static void _packRow(const unsigned char *line, int width, uint64_t *bits)
+{
+	uint64_t word;
+	int x;
+	int i;
+
+	for (x = 0; x + 64 <= width; x += 64){
+#ifdef __SSE2__
+		word = (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(line + x)));
+		word |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(line + x + 16))) << 16;
+		word |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(line + x + 32))) << 32;
+		word |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(line + x + 48))) << 48;
+#else
+		word = 0;
+		for (i = 0; i < 64; ++i){
+			word |= (uint64_t)(line[x + i] & 1) << i;
+		}
+#endif
+		bits[x >> 6] = word;
+	}
+
+	if (x < width){
+		word = 0;
+		for (i = 0; x + i < width; ++i){
+			word |= (uint64_t)(line[x + i] & 1) << i;
+		}
+		bits[x >> 6] = word;
+	}
+}
+
+/*The shared streaming pass over rows y0 .. y1-1.
+  Each binary row is written to binary + y * binStep; when bits is not NULL
+   binary is a single row of scratch that is packed into bits right away.
+  With src the whole image is converted as the window reaches it and y0 must
+   be 0; with src NULL gray must already hold every row.*/
+static void _grayThreshold(const unsigned char *src, int srcStep, int channels,
+                           int width, int height, int y0, int y1,
+                           unsigned char *gray, int grayStep,
+                           unsigned char *binary, int binStep,
+                           uint64_t *bits, int words,
+                           int block, int delta, int *work)
+{
+	int r;
+	int x;
+	int y;
+	int k;
+	int next;
+
+	if (width <= 0 || height <= 0 || y0 >= y1){
+		return;
+	}
+
+	r = block / 2;
+
+	//窗口最初用到的第0到r行先转成灰度
+	if (NULL != src){
+		for (k = 0; k <= r && k < height; ++k){
+			_grayRow(src + k * srcStep, channels, width, gray + k * grayStep);
+		}
+	}
+
+	//y0上下各r行，超出图像的部分重复边界上的行
+	for (x = 0; x < width; ++x){
+		work[x] = 0;
+	}
+	for (k = y0 - r; k <= y0 + r; ++k){
+		_addRow(gray + QR_MIN(QR_MAX(k, 0), height - 1) * grayStep, width, work);
+	}
+
+	for (y = y0; y < y1; ++y){
+		if (NULL == bits){
+			_thresholdRow(work, gray + y * grayStep, width, r, delta, binary + y * binStep);
+		} else {
+			_thresholdRow(work, gray + y * grayStep, width, r, delta, binary);
+			_packRow(binary, width, bits + (size_t)y * words);
+		}
+
+		//窗口下移一行：读入新的一行，去掉最上面一行
+		next = y + r + 1;
+		if (NULL != src && next < height){
+			_lumaRow(src + next * srcStep, channels, width, gray + next * grayStep,
+			         gray + QR_MAX(y - r, 0) * grayStep, work);
+		} else {
+			_slideRows(gray + QR_MIN(next, height - 1) * grayStep, gray + QR_MAX(y - r, 0) * grayStep, width, work);
+		}
+	}
+
+	return;
+}
+
+void QR_GrayThreshold(const unsigned char *src, int srcStep, int channels,
+                      int width, int height,
+                      unsigned char *gray, int grayStep,
+                      unsigned char *binary, int binStep,
+                      int block, int delta, int *work)
+{
+	_grayThreshold(src, srcStep, channels, width, height, 0, height, gray, grayStep,
+	               binary, binStep, NULL, 0, block, delta, work);
+}
+
+void QR_GrayThresholdBits(const unsigned char *src, int srcStep, int channels,
+                          int width, int height,
+                          unsigned char *gray, int grayStep,
+                          uint64_t *bits, int words,
+                          int block, int delta, int *work)
+{
+	//work后半部分用作一行的字节结果
+	_grayThreshold(src, srcStep, channels, width, height, 0, height, gray, grayStep,
+	               (unsigned char *)(work + width), 0, bits, words, block, delta, work);
+}
+
+void QR_GrayRows(const unsigned char *src, int srcStep, int channels,
+                 int width, int height,
+                 unsigned char *gray, int grayStep)
+{
+	int y;
+
+	for (y = 0; y < height; ++y){
+		_grayRow(src + y * srcStep, channels, width, gray + y * grayStep);
+	}
+}
+
+void QR_ThresholdBitRows(const unsigned char *gray, int grayStep,
+                         int width, int height, int y0, int y1,
+                         uint64_t *bits, int words,
+                         int block, int delta, int *work)
+{
+	_grayThreshold(NULL, 0, 1, width, height, y0, y1, (unsigned char *)gray, grayStep,
+	               (unsigned char *)(work + width), 0, bits, words, block, delta, work);
+}
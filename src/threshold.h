@@ -0,0 +1,46 @@
+#ifndef _THRESHOLD_H_
+#define _THRESHOLD_H_
+
+#include <stdint.h>
+
+/*Convert an image to luma and binarize it in one streaming pass.
+  Each source row is read once: its luma is written to gray and added to a
+   running column sum over the block rows around the current output row, the
+   sliding block x block window sum along that row then decides the binary
+   pixel.
+  The result matches cvtColor(CV_RGB2GRAY) followed by
+   adaptiveThreshold(ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY, block, delta):
+   a pixel is white when it is greater than the rounded window mean minus delta,
+   with the border replicated.
+  channels is 1, 3 or 4; block must be odd.
+  work must hold width ints.*/
+extern void QR_GrayThreshold(const unsigned char *src, int srcStep, int channels,
+                             int width, int height,
+                             unsigned char *gray, int grayStep,
+                             unsigned char *binary, int binStep,
+                             int block, int delta, int *work);
+
+/*The same pass writing a 1 bit per pixel bitmap (see bitmap.h) with words
+   64-bit words per row instead of a byte image.
+  work must hold 2 * width ints.*/
+extern void QR_GrayThresholdBits(const unsigned char *src, int srcStep, int channels,
+                                 int width, int height,
+                                 unsigned char *gray, int grayStep,
+                                 uint64_t *bits, int words,
+                                 int block, int delta, int *work);
+
+/*QR_GrayThresholdBits split in two, so row bands can run on different
+   threads.
+  QR_GrayRows converts height rows to luma. Once every row of gray is
+   converted, QR_ThresholdBitRows writes rows y0 .. y1-1 of the bitmap of
+   the whole width x height image, the same as QR_GrayThresholdBits does.
+  work must hold 2 * width ints.*/
+extern void QR_GrayRows(const unsigned char *src, int srcStep, int channels,
+                        int width, int height,
+                        unsigned char *gray, int grayStep);
+extern void QR_ThresholdBitRows(const unsigned char *gray, int grayStep,
+                                int width, int height, int y0, int y1,
+                                uint64_t *bits, int words,
+                                int block, int delta, int *work);
+
+#endif
@@ -0,0 +1,267 @@
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define QR_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#include "transition.h"
+
+/*Report every i in [0, n) with a[i] != b[i] as base + i.
+  Comparing a line with itself shifted by one pixel gives its transitions,
+   comparing two rows gives the columns whose colour changes between them.*/
+typedef int (*QRTransitionFunc)(const unsigned char *a, const unsigned char *b, int n, int base, int *out);
+
+static int _findTransitionsScalar(const unsigned char *a, const unsigned char *b, int n, int base, int *out)
+{
+	uint64_t wa;
+	uint64_t wb;
+	int nout;
+	int i;
+	int end;
+
+	nout = 0;
+	i = 0;
+	while (i < n){
+		//一次比较8个像素，颜色不变的区域直接跳过
+		if (i + 8 <= n){
+			memcpy(&wa, a + i, sizeof(wa));
+			memcpy(&wb, b + i, sizeof(wb));
+			if (wa == wb){
+				i += 8;
+				continue;
+			}
+			end = i + 8;
+		} else {
+			end = i + 1;
+		}
+
+		for (; i < end; ++i){
+			if (a[i] != b[i]){
+				out[nout++] = base + i;
+			}
+		}
+	}
+
+	return nout;
+}
+
+//处理剩余不足一个向量宽度的像素
+static int _findTransitionsTail(const unsigned char *a, const unsigned char *b, int i, int n, int base, int *out, int nout)
+{
+	for (; i < n; ++i){
+		if (a[i] != b[i]){
+			out[nout++] = base + i;
+		}
+	}
+
+	return nout;
+}
+
+#ifdef QR_HAVE_X86
+
+/*The vector kernels compare w bytes of a and b at a time; each set bit of the
+   inverted movemask is a difference, extracted with a bit scan.*/
+static int _findTransitionsSSE2(const unsigned char *a, const unsigned char *b, int n, int base, int *out)
+{
+	__m128i va;
+	__m128i vb;
+	unsigned int mask;
+	int nout;
+	int i;
+
+	nout = 0;
+	for (i = 0; i + 16 <= n; i += 16){
+		va = _mm_loadu_si128((const __m128i *)(a + i));
+		vb = _mm_loadu_si128((const __m128i *)(b + i));
+		mask = (~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xFFFF;
+		while (0 != mask){
+			out[nout++] = base + i + __builtin_ctz(mask);
+			mask &= mask - 1;
+		}
+	}
+
+	return _findTransitionsTail(a, b, i, n, base, out, nout);
+}
+
+__attribute__((target("avx2")))
+static int _findTransitionsAVX2(const unsigned char *a, const unsigned char *b, int n, int base, int *out)
+{
+	__m256i va;
+	__m256i vb;
+	unsigned int mask;
+	int nout;
+	int i;
+
+	nout = 0;
+	for (i = 0; i + 32 <= n; i += 32){
+		va = _mm256_loadu_si256((const __m256i *)(a + i));
+		vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+		while (0 != mask){
+			out[nout++] = base + i + __builtin_ctz(mask);
+			mask &= mask - 1;
+		}
+	}
+
+	return _findTransitionsTail(a, b, i, n, base, out, nout);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static int _findTransitionsAVX512(const unsigned char *a, const unsigned char *b, int n, int base, int *out)
+{
+	__m512i va;
+	__m512i vb;
+	unsigned long long mask;
+	int nout;
+	int i;
+
+	nout = 0;
+	for (i = 0; i + 64 <= n; i += 64){
+		va = _mm512_loadu_si512((const void *)(a + i));
+		vb = _mm512_loadu_si512((const void *)(b + i));
+		mask = (unsigned long long)_mm512_cmpneq_epi8_mask(va, vb);
+		while (0 != mask){
+			out[nout++] = base + i + __builtin_ctzll(mask);
+			mask &= mask - 1;
+		}
+	}
+
+	return _findTransitionsTail(a, b, i, n, base, out, nout);
+}
+
+#endif
+
+static const QRTransitionFunc g_TransitionFuncs[QR_TRANSITION_MAX] = {
+	NULL,
+	_findTransitionsScalar,
+#ifdef QR_HAVE_X86
+	_findTransitionsSSE2,
+	_findTransitionsAVX2,
+	_findTransitionsAVX512,
+#else
+	NULL,
+	NULL,
+	NULL,
+#endif
+};
+
+static const char* g_TransitionNames[QR_TRANSITION_MAX] = {
+	"auto",
+	"scalar",
+	"sse2",
+	"avx2",
+	"avx512",
+};
+
+//0表示还没有选择，自动选择只做一次，band线程会同时查询
+static int g_TransitionPath = 0;
+static pthread_once_t g_TransitionOnce = PTHREAD_ONCE_INIT;
+
+int QR_TransitionPathSupported(int path)
+{
+	if (path <= QR_TRANSITION_AUTO || path >= QR_TRANSITION_MAX){
+		return 0;
+	}
+
+	if (NULL == g_TransitionFuncs[path]){
+		return 0;
+	}
+
+#ifdef QR_HAVE_X86
+	__builtin_cpu_init();
+	switch (path){
+		case QR_TRANSITION_SSE2:
+			return __builtin_cpu_supports("sse2") ? 1 : 0;
+		case QR_TRANSITION_AVX2:
+			return __builtin_cpu_supports("avx2") ? 1 : 0;
+		case QR_TRANSITION_AVX512:
+			return (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) ? 1 : 0;
+		default:
+			break;
+	}
+#endif
+
+	return 1;
+}
+
+static int _selectTransitionPath(void)
+{
+	int path;
+
+	for (path = QR_TRANSITION_MAX - 1; path > QR_TRANSITION_SCALAR; --path){
+		if (QR_TransitionPathSupported(path)){
+			return path;
+		}
+	}
+
+	return QR_TRANSITION_SCALAR;
+}
+
+static void _initTransitionPath(void)
+{
+	g_TransitionPath = _selectTransitionPath();
+}
+
+int QR_SetTransitionPath(int path)
+{
+	if (QR_TRANSITION_AUTO == path){
+		path = _selectTransitionPath();
+	} else if (!QR_TransitionPathSupported(path)){
+		return -1;
+	}
+
+	//先完成自动选择，之后的查询不会再覆盖这里的设置
+	pthread_once(&g_TransitionOnce, _initTransitionPath);
+	g_TransitionPath = path;
+
+	return 0;
+}
+
+int QR_GetTransitionPath(void)
+{
+	pthread_once(&g_TransitionOnce, _initTransitionPath);
+
+	return g_TransitionPath;
+}
+
+const char* QR_TransitionPathName(int path)
+{
+	if (path < 0 || path >= QR_TRANSITION_MAX){
+		return "unknown";
+	}
+
+	return g_TransitionNames[path];
+}
+
+int QR_FindTransitions(const unsigned char *line, int n, int stride, int *edges)
+{
+	int nedges;
+	int x;
+
+	if (n < 2){
+		return 0;
+	}
+
+	if (1 == stride){
+		return g_TransitionFuncs[QR_GetTransitionPath()](line, line + 1, n - 1, 1, edges);
+	}
+
+	//列方向按步长逐个比较
+	nedges = 0;
+	for (x = 1; x < n; ++x){
+		if (line[x * stride] != line[(x - 1) * stride]){
+			edges[nedges++] = x;
+		}
+	}
+
+	return nedges;
+}
+
+int QR_FindChanges(const unsigned char *a, const unsigned char *b, int n, int *out)
+{
+	return g_TransitionFuncs[QR_GetTransitionPath()](a, b, n, 0, out);
+}
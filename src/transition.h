@@ -0,0 +1,33 @@
+#ifndef _TRANSITION_H_
+#define _TRANSITION_H_
+
+//颜色跳变查找的实现方式
+enum{
+	QR_TRANSITION_AUTO = 0, //运行时根据CPUID选择
+	QR_TRANSITION_SCALAR,
+	QR_TRANSITION_SSE2,
+	QR_TRANSITION_AVX2,
+	QR_TRANSITION_AVX512,
+	QR_TRANSITION_MAX,
+};
+
+/*Find the colour transitions along one line of a binary image.
+  edges[i] receives every position x (1 <= x < n) whose pixel differs from the
+   pixel at x-1, in increasing order; edges must hold at least n entries.
+  stride is the distance in bytes between two neighbouring pixels of the line.
+  Return: The number of transitions found.*/
+extern int QR_FindTransitions(const unsigned char *line, int n, int stride, int *edges);
+
+/*Find the positions where two rows differ.
+  out[i] receives every x (0 <= x < n) with a[x] != b[x], in increasing order.
+  Return: The number of positions found.*/
+extern int QR_FindChanges(const unsigned char *a, const unsigned char *b, int n, int *out);
+
+//强制使用某种实现，CPU不支持时返回-1，QR_TRANSITION_AUTO恢复自动选择
+//只能在没有扫描进行时调用
+extern int QR_SetTransitionPath(int path);
+extern int QR_GetTransitionPath(void);
+extern int QR_TransitionPathSupported(int path);
+extern const char* QR_TransitionPathName(int path);
+
+#endif
@@ -0,0 +1,105 @@
+#include <stddef.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "transpose.h"
+
+//tile的边长，64*64*2字节可以放进L1
+#define QR_TRANSPOSE_TILE  64
+#define QR_TRANSPOSE_BLOCK 16
+
+static void _transposeScalar(const unsigned char *src, int sstride, unsigned char *dst, int dstride, int w, int h)
+{
+	int x;
+	int y;
+
+	for (y = 0; y < h; ++y){
+		for (x = 0; x < w; ++x){
+			dst[x * dstride + y] = src[y * sstride + x];
+		}
+	}
+
+	return;
+}
+
+#ifdef __SSE2__
+/*Transpose one 16x16 block.
+  Interleaving row i with row i+8 four times in a row is a perfect shuffle of
+   the row and column bits, which ends up as the transpose.*/
+static void _transposeBlockSSE2(const unsigned char *src, int sstride, unsigned char *dst, int dstride)
+{
+	__m128i a[16];
+	__m128i b[16];
+	__m128i *in;
+	__m128i *out;
+	__m128i *tmp;
+	int i;
+	int k;
+
+	for (i = 0; i < 16; ++i){
+		a[i] = _mm_loadu_si128((const __m128i *)(src + i * sstride));
+	}
+
+	in = a;
+	out = b;
+	for (k = 0; k < 4; ++k){
+		for (i = 0; i < 8; ++i){
+			out[2 * i] = _mm_unpacklo_epi8(in[i], in[i + 8]);
+			out[2 * i + 1] = _mm_unpackhi_epi8(in[i], in[i + 8]);
+		}
+		tmp = in;
+		in = out;
+		out = tmp;
+	}
+
+	for (i = 0; i < 16; ++i){
+		_mm_storeu_si128((__m128i *)(dst + i * dstride), in[i]);
+	}
+
+	return;
+}
+#endif
+
+void QR_Transpose8u(const unsigned char *src, int width, int height, unsigned char *dst)
+{
+	int tx;
+	int ty;
+	int tw;
+	int th;
+	int bx;
+	int by;
+	const unsigned char *s;
+	unsigned char *d;
+
+	for (ty = 0; ty < height; ty += QR_TRANSPOSE_TILE){
+		th = (height - ty < QR_TRANSPOSE_TILE) ? (height - ty) : QR_TRANSPOSE_TILE;
+		for (tx = 0; tx < width; tx += QR_TRANSPOSE_TILE){
+			tw = (width - tx < QR_TRANSPOSE_TILE) ? (width - tx) : QR_TRANSPOSE_TILE;
+			s = src + (size_t)ty * width + tx;
+			d = dst + (size_t)tx * height + ty;
+
+#ifdef __SSE2__
+			//完整的16x16块用SSE2，边上剩下的部分逐个像素处理
+			for (by = 0; by + QR_TRANSPOSE_BLOCK <= th; by += QR_TRANSPOSE_BLOCK){
+				for (bx = 0; bx + QR_TRANSPOSE_BLOCK <= tw; bx += QR_TRANSPOSE_BLOCK){
+					_transposeBlockSSE2(s + by * width + bx, width, d + bx * height + by, height);
+				}
+				if (bx < tw){
+					_transposeScalar(s + by * width + bx, width, d + bx * height + by, height, tw - bx, QR_TRANSPOSE_BLOCK);
+				}
+			}
+			if (by < th){
+				_transposeScalar(s + by * width, width, d + by, height, tw, th - by);
+			}
+#else
+			(void)bx;
+			(void)by;
+			_transposeScalar(s, width, d, height, tw, th);
+#endif
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,11 @@
+#ifndef _TRANSPOSE_H_
+#define _TRANSPOSE_H_
+
+/*Transpose an 8-bit image.
+  src is width x height with a stride of width bytes, dst receives the
+   height x width result with a stride of height bytes.
+  The image is walked in 64x64 tiles that fit in L1, each tile is transposed
+   in 16x16 blocks with SSE2 when it is available.*/
+extern void QR_Transpose8u(const unsigned char *src, int width, int height, unsigned char *dst);
+
+#endif